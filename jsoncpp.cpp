@@ -198,6 +198,19 @@ static inline void fixNumericLocale(char* begin, char* end) {
 #include <cstring>
 #include <istream>
 
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_READER_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define JSON_READER_AVX2 1
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER) && (JSON_READER_SSE2 || JSON_READER_AVX2)
+#include <intrin.h>
+#endif
+
 #if defined(_MSC_VER) && _MSC_VER < 1500 // VC++ 8.0 and below
 #define snprintf _snprintf
 #endif
@@ -214,7 +227,8 @@ namespace Json {
 
 Features::Features()
     : allowComments_(true), strictRoot_(false),
-      allowDroppedNullPlaceholders_(false), allowNumericKeys_(false) {}
+      allowDroppedNullPlaceholders_(false), allowNumericKeys_(false),
+      storeOffsets_(true), collectErrors_(true) {}
 
 Features Features::all() { return Features(); }
 
@@ -227,6 +241,14 @@ Features Features::strictMode() {
   return features;
 }
 
+Features Features::trusted() {
+  Features features;
+  features.allowComments_ = false;
+  features.storeOffsets_ = false;
+  features.collectErrors_ = false;
+  return features;
+}
+
 // Implementation of class Reader
 // ////////////////////////////////
 
@@ -247,6 +269,127 @@ static inline bool in(Reader::Char c,
   return c == c1 || c == c2 || c == c3 || c == c4 || c == c5;
 }
 
+static inline bool isSpace(Reader::Char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+#if JSON_READER_SSE2 || JSON_READER_AVX2
+/// Index of the lowest set bit of a non-zero movemask.
+static inline int lowestBit(unsigned int mask) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return int(index);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+/// First character of [current, end) that is not JSON whitespace, or end.
+static inline Reader::Location skipWhitespace(Reader::Location current,
+                                              Reader::Location end) {
+  // Compact documents have at most a single separator between tokens, so
+  // only a run of whitespace goes to the vector loops.
+  if (current == end || !isSpace(*current))
+    return current;
+  ++current;
+#if JSON_READER_AVX2
+  const __m256i space32 = _mm256_set1_epi8(' ');
+  const __m256i tab32 = _mm256_set1_epi8('\t');
+  const __m256i cr32 = _mm256_set1_epi8('\r');
+  const __m256i lf32 = _mm256_set1_epi8('\n');
+  for (; end - current >= 32; current += 32) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i*)current);
+    __m256i spaces = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space32),
+                        _mm256_cmpeq_epi8(chunk, tab32)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr32),
+                        _mm256_cmpeq_epi8(chunk, lf32)));
+    unsigned int other = ~(unsigned int)_mm256_movemask_epi8(spaces);
+    if (other)
+      return current + lowestBit(other);
+  }
+#endif
+#if JSON_READER_SSE2
+  const __m128i space16 = _mm_set1_epi8(' ');
+  const __m128i tab16 = _mm_set1_epi8('\t');
+  const __m128i cr16 = _mm_set1_epi8('\r');
+  const __m128i lf16 = _mm_set1_epi8('\n');
+  for (; end - current >= 16; current += 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i*)current);
+    __m128i spaces =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space16),
+                                  _mm_cmpeq_epi8(chunk, tab16)),
+                     _mm_or_si128(_mm_cmpeq_epi8(chunk, cr16),
+                                  _mm_cmpeq_epi8(chunk, lf16)));
+    unsigned int other = ~(unsigned int)_mm_movemask_epi8(spaces) & 0xFFFF;
+    if (other)
+      return current + lowestBit(other);
+  }
+#endif
+  while (current != end && isSpace(*current))
+    ++current;
+  return current;
+}
+
+/// First '"' or '\\' of [current, end), or end.
+static inline Reader::Location findQuoteOrBackslash(Reader::Location current,
+                                                    Reader::Location end) {
+#if JSON_READER_AVX2
+  const __m256i quote32 = _mm256_set1_epi8('"');
+  const __m256i backslash32 = _mm256_set1_epi8('\\');
+  for (; end - current >= 32; current += 32) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i*)current);
+    unsigned int special = (unsigned int)_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote32),
+                        _mm256_cmpeq_epi8(chunk, backslash32)));
+    if (special)
+      return current + lowestBit(special);
+  }
+#endif
+#if JSON_READER_SSE2
+  const __m128i quote16 = _mm_set1_epi8('"');
+  const __m128i backslash16 = _mm_set1_epi8('\\');
+  for (; end - current >= 16; current += 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i*)current);
+    unsigned int special = (unsigned int)_mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote16),
+                     _mm_cmpeq_epi8(chunk, backslash16)));
+    if (special)
+      return current + lowestBit(special);
+  }
+#endif
+  while (current != end && *current != '"' && *current != '\\')
+    ++current;
+  return current;
+}
+
+/// Character written as a backslash followed by \a escape, or 0 if that is
+/// not a one-letter escape sequence.
+static inline Reader::Char unescape(Reader::Char escape) {
+  switch (escape) {
+  case '"':
+    return '"';
+  case '/':
+    return '/';
+  case '\\':
+    return '\\';
+  case 'b':
+    return '\b';
+  case 'f':
+    return '\f';
+  case 'n':
+    return '\n';
+  case 'r':
+    return '\r';
+  case 't':
+    return '\t';
+  default:
+    return 0;
+  }
+}
+
 static bool containsNewLine(Reader::Location begin, Reader::Location end) {
   for (; begin < end; ++begin)
     if (*begin == '\n' || *begin == '\r')
@@ -258,13 +401,24 @@ static bool containsNewLine(Reader::Location begin, Reader::Location end) {
 // //////////////////////////////////////////////////////////////////
 
 Reader::Reader()
-    : errors_(), document_(), begin_(), end_(), current_(), lastValueEnd_(),
+    : errors_(), errorLocation_(0), document_(), begin_(), end_(), current_(), lastValueEnd_(),
       lastValue_(), commentsBefore_(), features_(Features::all()),
-      collectComments_() {}
+      collectComments_(), inSitu_(false)
+#if JSON_USE_VALUE_ARENA
+      ,
+      arena_(0)
+#endif
+{
+}
 
 Reader::Reader(const Features& features)
-    : errors_(), document_(), begin_(), end_(), current_(), lastValueEnd_(),
-      lastValue_(), commentsBefore_(), features_(features), collectComments_() {
+    : errors_(), errorLocation_(0), document_(), begin_(), end_(), current_(), lastValueEnd_(),
+      lastValue_(), commentsBefore_(), features_(features), collectComments_(), inSitu_(false)
+#if JSON_USE_VALUE_ARENA
+      ,
+      arena_(0)
+#endif
+{
 }
 
 bool
@@ -281,12 +435,36 @@ bool Reader::parse(std::istream& sin, Value& root, bool collectComments) {
   // Those would allow streamed input from a file, if parse() were a
   // template function.
 
-  // Since std::string is reference-counted, this at least does not
-  // create an extra copy.
-  std::string doc;
-  std::getline(sin, doc, (char)EOF);
-  return parse(doc, root, collectComments);
+  // Read straight into document_, which keeps error locations valid, rather
+  // than into a temporary that parse(std::string) would copy again.
+  document_.clear();
+  std::getline(sin, document_, (char)EOF);
+  const char* begin = document_.c_str();
+  return parse(begin, begin + document_.length(), root, collectComments);
+}
+
+bool Reader::parseInSitu(char* beginDoc,
+                         char* endDoc,
+                         Value& root,
+                         bool collectComments) {
+  inSitu_ = true;
+  bool successful = parse(beginDoc, endDoc, root, collectComments);
+  inSitu_ = false;
+  return successful;
+}
+
+#if JSON_USE_VALUE_ARENA
+bool Reader::parseInSitu(char* beginDoc,
+                         char* endDoc,
+                         Value& root,
+                         ValueArena& arena,
+                         bool collectComments) {
+  inSitu_ = true;
+  bool successful = parse(beginDoc, endDoc, root, arena, collectComments);
+  inSitu_ = false;
+  return successful;
 }
+#endif
 
 bool Reader::parse(const char* beginDoc,
                    const char* endDoc,
@@ -304,6 +482,7 @@ bool Reader::parse(const char* beginDoc,
   lastValue_ = 0;
   commentsBefore_ = "";
   errors_.clear();
+  errorLocation_ = 0;
   while (!nodes_.empty())
     nodes_.pop();
   nodes_.push(&root);
@@ -329,6 +508,19 @@ bool Reader::parse(const char* beginDoc,
   return successful;
 }
 
+#if JSON_USE_VALUE_ARENA
+bool Reader::parse(const char* beginDoc,
+                   const char* endDoc,
+                   Value& root,
+                   ValueArena& arena,
+                   bool collectComments) {
+  arena_ = &arena;
+  bool successful = parse(beginDoc, endDoc, root, collectComments);
+  arena_ = 0;
+  return successful;
+}
+#endif
+
 bool Reader::readValue() {
   Token token;
   skipCommentTokens(token);
@@ -350,11 +542,11 @@ bool Reader::readValue() {
   switch (token.type_) {
   case tokenObjectBegin:
     successful = readObject(token);
-    currentValue().setOffsetLimit(current_ - begin_);
+    storeOffsets(currentValue(), token.start_, current_);
     break;
   case tokenArrayBegin:
     successful = readArray(token);
-    currentValue().setOffsetLimit(current_ - begin_);
+    storeOffsets(currentValue(), token.start_, current_);
     break;
   case tokenNumber:
     successful = decodeNumber(token);
@@ -364,18 +556,15 @@ bool Reader::readValue() {
     break;
   case tokenTrue:
     currentValue() = true;
-    currentValue().setOffsetStart(token.start_ - begin_);
-    currentValue().setOffsetLimit(token.end_ - begin_);
+    storeOffsets(currentValue(), token.start_, token.end_);
     break;
   case tokenFalse:
     currentValue() = false;
-    currentValue().setOffsetStart(token.start_ - begin_);
-    currentValue().setOffsetLimit(token.end_ - begin_);
+    storeOffsets(currentValue(), token.start_, token.end_);
     break;
   case tokenNull:
     currentValue() = Value();
-    currentValue().setOffsetStart(token.start_ - begin_);
-    currentValue().setOffsetLimit(token.end_ - begin_);
+    storeOffsets(currentValue(), token.start_, token.end_);
     break;
   case tokenArraySeparator:
     if (features_.allowDroppedNullPlaceholders_) {
@@ -383,14 +572,12 @@ bool Reader::readValue() {
       // token.
       current_--;
       currentValue() = Value();
-      currentValue().setOffsetStart(current_ - begin_ - 1);
-      currentValue().setOffsetLimit(current_ - begin_);
+      storeOffsets(currentValue(), current_ - 1, current_);
       break;
     }
   // Else, fall through...
   default:
-    currentValue().setOffsetStart(token.start_ - begin_);
-    currentValue().setOffsetLimit(token.end_ - begin_);
+    storeOffsets(currentValue(), token.start_, token.end_);
     return addError("Syntax error: value, object or array expected.", token);
   }
 
@@ -490,15 +677,7 @@ bool Reader::readToken(Token& token) {
   return true;
 }
 
-void Reader::skipSpaces() {
-  while (current_ != end_) {
-    Char c = *current_;
-    if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
-      ++current_;
-    else
-      break;
-  }
-}
+void Reader::skipSpaces() { current_ = skipWhitespace(current_, end_); }
 
 bool Reader::match(Location pattern, int patternLength) {
   if (end_ - current_ < patternLength)
@@ -548,7 +727,7 @@ Reader::addComment(Location begin, Location end, CommentPlacement placement) {
 bool Reader::readCStyleComment() {
   while (current_ != end_) {
     Char c = getNextChar();
-    if (c == '*' && *current_ == '/')
+    if (c == '*' && current_ != end_ && *current_ == '/')
       break;
   }
   return getNextChar() == '/';
@@ -573,32 +752,43 @@ void Reader::readNumber() {
 }
 
 bool Reader::readString() {
-  Char c = 0;
-  while (current_ != end_) {
-    c = getNextChar();
-    if (c == '\\')
-      getNextChar();
-    else if (c == '"')
-      break;
+  for (;;) {
+    current_ = findQuoteOrBackslash(current_, end_);
+    if (current_ == end_)
+      return false;
+    if (*current_++ == '"')
+      return true;
+    if (current_ == end_) // backslash ending the document
+      return false;
+    ++current_;
   }
-  return c == '"';
 }
 
-bool Reader::readObject(Token& tokenStart) {
+bool Reader::readObject(Token& /*tokenStart*/) {
   Token tokenName;
   std::string name;
-  currentValue() = Value(objectValue);
-  currentValue().setOffsetStart(tokenStart.start_ - begin_);
+  char* inSituName = 0;
+#if JSON_USE_VALUE_ARENA
+  if (arena_)
+    currentValue() = Value(objectValue, *arena_);
+  else
+#endif
+    currentValue() = Value(objectValue);
   while (readToken(tokenName)) {
     bool initialTokenOk = true;
     while (tokenName.type_ == tokenComment && initialTokenOk)
       initialTokenOk = readToken(tokenName);
     if (!initialTokenOk)
       break;
-    if (tokenName.type_ == tokenObjectEnd && name.empty()) // empty object
+    if (tokenName.type_ == tokenObjectEnd && name.empty() &&
+        !(inSituName && *inSituName)) // empty object
       return true;
     name = "";
-    if (tokenName.type_ == tokenString) {
+    inSituName = 0;
+    if (tokenName.type_ == tokenString && inSitu_) {
+      if (!decodeStringInSitu(tokenName, inSituName))
+        return recoverFromError(tokenObjectEnd);
+    } else if (tokenName.type_ == tokenString) {
       if (!decodeString(tokenName, name))
         return recoverFromError(tokenObjectEnd);
     } else if (tokenName.type_ == tokenNumber && features_.allowNumericKeys_) {
@@ -615,7 +805,22 @@ bool Reader::readObject(Token& tokenStart) {
       return addErrorAndRecover(
           "Missing ':' after object member name", colon, tokenObjectEnd);
     }
-    Value& value = currentValue()[name];
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+    const char* key = inSituName ? inSituName : name.c_str();
+    const char* canonical = StaticKey::find(key);
+    Value& value =
+        canonical
+            ? currentValue().resolveReference(
+                  canonical, Value::CZString::noDuplication, true)
+            : currentValue().resolveReference(
+                  key,
+                  inSituName ? Value::CZString::duplicateOnCopy
+                             : Value::CZString::duplicate,
+                  false);
+#else
+    Value& value = inSituName ? currentValue()[inSituName]
+                              : currentValue()[name];
+#endif
     nodes_.push(&value);
     bool ok = readValue();
     nodes_.pop();
@@ -639,11 +844,15 @@ bool Reader::readObject(Token& tokenStart) {
       "Missing '}' or object member name", tokenName, tokenObjectEnd);
 }
 
-bool Reader::readArray(Token& tokenStart) {
-  currentValue() = Value(arrayValue);
-  currentValue().setOffsetStart(tokenStart.start_ - begin_);
+bool Reader::readArray(Token& /*tokenStart*/) {
+#if JSON_USE_VALUE_ARENA
+  if (arena_)
+    currentValue() = Value(arrayValue, *arena_);
+  else
+#endif
+    currentValue() = Value(arrayValue);
   skipSpaces();
-  if (*current_ == ']') // empty array
+  if (current_ != end_ && *current_ == ']') // empty array
   {
     Token endArray;
     readToken(endArray);
@@ -652,6 +861,10 @@ bool Reader::readArray(Token& tokenStart) {
   int index = 0;
   for (;;) {
     Value& value = currentValue()[index++];
+    // Growing the array may move the previous element, which is the value a
+    // same-line comment after it would attach to.
+    if (collectComments_ && index > 1)
+      lastValue_ = &currentValue()[index - 2];
     nodes_.push(&value);
     bool ok = readValue();
     nodes_.pop();
@@ -676,61 +889,103 @@ bool Reader::readArray(Token& tokenStart) {
   return true;
 }
 
-bool Reader::decodeNumber(Token& token) {
-  Value decoded;
-  if (!decodeNumber(token, decoded))
+#if defined(JSON_HAS_INT64)
+/// Value of eight ASCII digits at \a p, or false if one of them is not a digit.
+static inline bool decodeEightDigits(Reader::Location p, UInt64& value) {
+  UInt64 chunk = 0;
+  for (int index = 7; index >= 0; --index) // one little-endian load
+    chunk = (chunk << 8) | (unsigned char)p[index];
+  // Each byte must be in 0x30..0x39: high nibble 3, and still 3 after +6.
+  if ((chunk & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL ||
+      ((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) !=
+          0x3030303030303030ULL)
     return false;
-  currentValue() = decoded;
-  currentValue().setOffsetStart(token.start_ - begin_);
-  currentValue().setOffsetLimit(token.end_ - begin_);
+  chunk -= 0x3030303030303030ULL;
+  chunk = chunk * 10 + (chunk >> 8); // pairs of digits
+  value = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+           (((chunk >> 16) & 0x000000FF000000FFULL) *
+            (1 + (10000ULL << 32)))) >>
+          32;
   return true;
 }
+#endif
 
-bool Reader::decodeNumber(Token& token, Value& decoded) {
-  bool isDouble = false;
-  for (Location inspect = token.start_; inspect != token.end_; ++inspect) {
-    isDouble = isDouble || in(*inspect, '.', 'e', 'E', '+') ||
-               (*inspect == '-' && inspect != token.start_);
-  }
-  if (isDouble)
-    return decodeDouble(token, decoded);
-  // Attempts to parse the number as an integer. If the number is
-  // larger than the maximum supported value of an integer then
-  // we decode the number as a double.
-  Location current = token.start_;
-  bool isNegative = *current == '-';
+/** Decodes [current, end) as an optionally negative integer in a single pass.
+ * Returns false as soon as something else shows up (fraction, exponent, a
+ * sign in the middle) or the value does not fit in a LargestInt/LargestUInt;
+ * the token is then left to decodeDouble().
+ */
+static bool decodeInteger(Reader::Location current,
+                          Reader::Location end,
+                          bool& isNegative,
+                          Value::LargestUInt& value) {
+  isNegative = *current == '-';
   if (isNegative)
     ++current;
+  value = 0;
+#if defined(JSON_HAS_INT64)
+  // Sixteen digits cannot overflow, so the first ones go eight at a time.
+  for (int chunks = 0; chunks < 2 && end - current >= 8; ++chunks) {
+    UInt64 digits;
+    if (!decodeEightDigits(current, digits))
+      break;
+    value = value * 100000000 + digits;
+    current += 8;
+  }
+#endif
   Value::LargestUInt maxIntegerValue =
-      isNegative ? Value::LargestUInt(-Value::minLargestInt)
+      isNegative ? Value::LargestUInt(Value::maxLargestInt) + 1
                  : Value::maxLargestUInt;
   Value::LargestUInt threshold = maxIntegerValue / 10;
-  Value::LargestUInt value = 0;
-  while (current < token.end_) {
-    Char c = *current++;
+  while (current < end) {
+    Reader::Char c = *current++;
     if (c < '0' || c > '9')
-      return addError("'" + std::string(token.start_, token.end_) +
-                          "' is not a number.",
-                      token);
+      return false;
     Value::UInt digit(c - '0');
     if (value >= threshold) {
       // We've hit or exceeded the max value divided by 10 (rounded down). If
       // a) we've only just touched the limit, b) this is the last digit, and
       // c) it's small enough to fit in that rounding delta, we're okay.
       // Otherwise treat this number as a double to avoid overflow.
-      if (value > threshold || current != token.end_ ||
-          digit > maxIntegerValue % 10) {
-        return decodeDouble(token, decoded);
-      }
+      if (value > threshold || current != end ||
+          digit > maxIntegerValue % 10)
+        return false;
     }
     value = value * 10 + digit;
   }
+  return true;
+}
+
+/// Stores an integer accepted by decodeInteger() with the type the reader
+/// has always used: intValue up to maxInt and for negatives, uintValue above.
+static inline void storeInteger(Value& target,
+                                bool isNegative,
+                                Value::LargestUInt value) {
   if (isNegative)
-    decoded = -Value::LargestInt(value);
+    target = value ? -Value::LargestInt(value - 1) - 1 : Value::LargestInt(0);
   else if (value <= Value::LargestUInt(Value::maxInt))
-    decoded = Value::LargestInt(value);
+    target = Value::LargestInt(value);
   else
-    decoded = value;
+    target = value;
+}
+
+bool Reader::decodeNumber(Token& token) {
+  bool isNegative;
+  Value::LargestUInt value;
+  if (!decodeInteger(token.start_, token.end_, isNegative, value))
+    return decodeDouble(token);
+  Value& target = currentValue();
+  storeInteger(target, isNegative, value);
+  storeOffsets(target, token.start_, token.end_);
+  return true;
+}
+
+bool Reader::decodeNumber(Token& token, Value& decoded) {
+  bool isNegative;
+  Value::LargestUInt value;
+  if (!decodeInteger(token.start_, token.end_, isNegative, value))
+    return decodeDouble(token, decoded);
+  storeInteger(decoded, isNegative, value);
   return true;
 }
 
@@ -738,22 +993,17 @@ bool Reader::decodeDouble(Token& token) {
   Value decoded;
   if (!decodeDouble(token, decoded))
     return false;
-  currentValue() = decoded;
-  currentValue().setOffsetStart(token.start_ - begin_);
-  currentValue().setOffsetLimit(token.end_ - begin_);
+  currentValue().swap(decoded);
+  storeOffsets(currentValue(), token.start_, token.end_);
   return true;
 }
 
-bool Reader::decodeDouble(Token& token, Value& decoded) {
-  double value = 0;
+/// Parses [begin, end) as a double, leaving \a value untouched on failure.
+static bool
+decodeReal(Reader::Location begin, Reader::Location end, double& value) {
   const int bufferSize = 32;
   int count;
-  int length = int(token.end_ - token.start_);
-
-  // Sanity check to avoid buffer overflow exploits.
-  if (length < 0) {
-    return addError("Unable to parse token length", token);
-  }
+  int length = int(end - begin);
 
   // Avoid using a string constant for the format control string given to
   // sscanf, as this can cause hard to debug crashes on OS X. See here for more
@@ -763,16 +1013,26 @@ bool Reader::decodeDouble(Token& token, Value& decoded) {
   char format[] = "%lf";
 
   if (length <= bufferSize) {
-    Char buffer[bufferSize + 1];
-    memcpy(buffer, token.start_, length);
+    Reader::Char buffer[bufferSize + 1];
+    memcpy(buffer, begin, length);
     buffer[length] = 0;
     count = sscanf(buffer, format, &value);
   } else {
-    std::string buffer(token.start_, token.end_);
+    std::string buffer(begin, end);
     count = sscanf(buffer.c_str(), format, &value);
   }
+  return count == 1;
+}
+
+bool Reader::decodeDouble(Token& token, Value& decoded) {
+  double value = 0;
 
-  if (count != 1)
+  // Sanity check to avoid buffer overflow exploits.
+  if (token.end_ - token.start_ < 0) {
+    return addError("Unable to parse token length", token);
+  }
+
+  if (!decodeReal(token.start_, token.end_, value))
     return addError("'" + std::string(token.start_, token.end_) +
                         "' is not a number.",
                     token);
@@ -781,12 +1041,25 @@ bool Reader::decodeDouble(Token& token, Value& decoded) {
 }
 
 bool Reader::decodeString(Token& token) {
+  if (inSitu_) {
+    char* decoded;
+    if (!decodeStringInSitu(token, decoded))
+      return false;
+    currentValue() = Value(StaticString(decoded)); // copies duplicate it
+    storeOffsets(currentValue(), token.start_, token.end_);
+    return true;
+  }
   std::string decoded;
   if (!decodeString(token, decoded))
     return false;
-  currentValue() = decoded;
-  currentValue().setOffsetStart(token.start_ - begin_);
-  currentValue().setOffsetLimit(token.end_ - begin_);
+#if JSON_USE_VALUE_ARENA
+  if (arena_)
+    currentValue() = Value(decoded.data(), decoded.data() + decoded.size(),
+                           *arena_);
+  else
+#endif
+    currentValue() = decoded;
+  storeOffsets(currentValue(), token.start_, token.end_);
   return true;
 }
 
@@ -795,6 +1068,11 @@ bool Reader::decodeString(Token& token, std::string& decoded) {
   Location current = token.start_ + 1; // skip '"'
   Location end = token.end_ - 1;       // do not include '"'
   while (current != end) {
+    Location run = findQuoteOrBackslash(current, end);
+    decoded.append(current, run);
+    if (run == end)
+      break;
+    current = run;
     Char c = *current++;
     if (c == '"')
       break;
@@ -802,44 +1080,56 @@ bool Reader::decodeString(Token& token, std::string& decoded) {
       if (current == end)
         return addError("Empty escape sequence in string", token, current);
       Char escape = *current++;
-      switch (escape) {
-      case '"':
-        decoded += '"';
-        break;
-      case '/':
-        decoded += '/';
-        break;
-      case '\\':
-        decoded += '\\';
-        break;
-      case 'b':
-        decoded += '\b';
-        break;
-      case 'f':
-        decoded += '\f';
-        break;
-      case 'n':
-        decoded += '\n';
-        break;
-      case 'r':
-        decoded += '\r';
-        break;
-      case 't':
-        decoded += '\t';
-        break;
-      case 'u': {
+      if (escape == 'u') {
         unsigned int unicode;
         if (!decodeUnicodeCodePoint(token, current, end, unicode))
           return false;
         decoded += codePointToUTF8(unicode);
-      } break;
-      default:
+      } else if (Char unescaped = unescape(escape)) {
+        decoded += unescaped;
+      } else {
         return addError("Bad escape sequence in string", token, current);
       }
+    }
+  }
+  return true;
+}
+
+bool Reader::decodeStringInSitu(Token& token, char*& decoded) {
+  // The token lies in the caller's mutable buffer (see parseInSitu()). The
+  // decoded text is never longer than its source, so it is written over it.
+  char* out = const_cast<char*>(token.start_) + 1;
+  decoded = out;
+  Location current = token.start_ + 1; // skip '"'
+  Location end = token.end_ - 1;       // do not include '"'
+  while (current != end) {
+    Location run = findQuoteOrBackslash(current, end);
+    if (out != current)
+      memmove(out, current, run - current);
+    out += run - current;
+    if (run == end)
+      break;
+    current = run;
+    Char c = *current++;
+    if (c == '"')
+      break;
+    if (current == end)
+      return addError("Empty escape sequence in string", token, current);
+    Char escape = *current++;
+    if (escape == 'u') {
+      unsigned int unicode;
+      if (!decodeUnicodeCodePoint(token, current, end, unicode))
+        return false;
+      std::string utf8 = codePointToUTF8(unicode);
+      memcpy(out, utf8.data(), utf8.size());
+      out += utf8.size();
+    } else if (Char unescaped = unescape(escape)) {
+      *out++ = unescaped;
     } else {
-      decoded += c;
+      return addError("Bad escape sequence in string", token, current);
     }
   }
+  *out = 0; // at the latest over the closing quote
   return true;
 }
 
@@ -902,6 +1192,11 @@ bool Reader::decodeUnicodeEscapeSequence(Token& token,
 
 bool
 Reader::addError(const std::string& message, Token& token, Location extra) {
+  if (!features_.collectErrors_) {
+    if (!errorLocation_)
+      errorLocation_ = token.start_;
+    return false;
+  }
   ErrorInfo info;
   info.token_ = token;
   info.message_ = message;
@@ -911,6 +1206,8 @@ Reader::addError(const std::string& message, Token& token, Location extra) {
 }
 
 bool Reader::recoverFromError(TokenType skipUntilToken) {
+  if (!features_.collectErrors_) // no further errors to report
+    return false;
   int errorCount = int(errors_.size());
   Token skip;
   for (;;) {
@@ -932,6 +1229,13 @@ bool Reader::addErrorAndRecover(const std::string& message,
 
 Value& Reader::currentValue() { return *(nodes_.top()); }
 
+void Reader::storeOffsets(Value& value, Location start, Location limit) {
+  if (features_.storeOffsets_) {
+    value.setOffsetStart(start - begin_);
+    value.setOffsetLimit(limit - begin_);
+  }
+}
+
 Reader::Char Reader::getNextChar() {
   if (current_ == end_)
     return 0;
@@ -995,6 +1299,9 @@ std::string Reader::getFormattedErrorMessages() const {
       formattedMessage +=
           "See " + getLocationLineAndColumn(error.extra_) + " for detail.\n";
   }
+  if (errorLocation_)
+    formattedMessage +=
+        "* " + getLocationLineAndColumn(errorLocation_) + "\n  Syntax error\n";
   return formattedMessage;
 }
 
@@ -1010,9 +1317,432 @@ std::vector<Reader::StructuredError> Reader::getStructuredErrors() const {
     structured.message = error.message_;
     allErrors.push_back(structured);
   }
+  if (errorLocation_) {
+    Reader::StructuredError structured;
+    structured.offset_start = errorLocation_ - begin_;
+    structured.offset_limit = structured.offset_start;
+    structured.message = "Syntax error";
+    allErrors.push_back(structured);
+  }
   return allErrors;
 }
 
+bool Reader::good() const { return errors_.empty() && !errorLocation_; }
+
+// Implementation of class IncrementalReader
+// ////////////////////////////////
+
+IncrementalReader::IncrementalReader()
+    : nodes_(), features_(Features::all()), root_(0), slot_(0),
+      state_(stateFailed), resume_(stateFailed), stringIsName_(false),
+      token_(), name_(), literal_(0), matched_(0), unicode_(0),
+      highSurrogate_(0), hexDigits_(0), tokenStart_(0), offset_(0), chunk_(0),
+      error_("No document: reset() was not called"), errorOffset_(0) {}
+
+IncrementalReader::IncrementalReader(const Features& features)
+    : nodes_(), features_(features), root_(0), slot_(0), state_(stateFailed),
+      resume_(stateFailed), stringIsName_(false), token_(), name_(),
+      literal_(0), matched_(0), unicode_(0), highSurrogate_(0), hexDigits_(0),
+      tokenStart_(0), offset_(0), chunk_(0),
+      error_("No document: reset() was not called"), errorOffset_(0) {}
+
+void IncrementalReader::reset(Value& root) {
+  root = Value();
+  root_ = &root;
+  slot_ = &root;
+  nodes_.clear();
+  token_.clear();
+  name_.clear();
+  error_.clear();
+  state_ = expectValue;
+  highSurrogate_ = 0;
+  offset_ = 0;
+  errorOffset_ = 0;
+}
+
+const char* IncrementalReader::feed(const char* beginDoc, const char* endDoc) {
+  const char* current = beginDoc;
+  chunk_ = beginDoc;
+  while (current != endDoc && state_ != stateDone && state_ != stateFailed) {
+    switch (state_) {
+    case inString: {
+      Reader::Location run = findQuoteOrBackslash(current, endDoc);
+      token_.append(current, run);
+      current = run;
+      if (current == endDoc)
+        break;
+      if (*current++ == '"')
+        endString(offsetOf(current));
+      else
+        state_ = inEscape;
+      break;
+    }
+    case inEscape: {
+      Reader::Char escape = *current;
+      if (escape == 'u') {
+        unicode_ = 0;
+        hexDigits_ = 0;
+        state_ = inUnicode;
+      } else if (Reader::Char unescaped = unescape(escape)) {
+        token_ += unescaped;
+        state_ = inString;
+      } else {
+        fail("Bad escape sequence in string", offsetOf(current));
+        break;
+      }
+      ++current;
+      break;
+    }
+    case inUnicode: {
+      Reader::Char c = *current;
+      unicode_ *= 16;
+      if (c >= '0' && c <= '9')
+        unicode_ += c - '0';
+      else if (c >= 'a' && c <= 'f')
+        unicode_ += c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F')
+        unicode_ += c - 'A' + 10;
+      else {
+        fail("Bad unicode escape sequence in string: hexadecimal digit "
+             "expected.",
+             offsetOf(current));
+        break;
+      }
+      ++current;
+      if (++hexDigits_ == 4)
+        endUnicode();
+      break;
+    }
+    case inSurrogateEscape:
+    case inSurrogateU:
+      if (*current != (state_ == inSurrogateEscape ? '\\' : 'u')) {
+        fail(*current == '"' ? "additional six characters expected to parse "
+                               "unicode surrogate pair."
+                             : "expecting another \\u token to begin the "
+                               "second half of a unicode surrogate pair",
+             offsetOf(current));
+        break;
+      }
+      ++current;
+      if (state_ == inSurrogateEscape) {
+        state_ = inSurrogateU;
+      } else {
+        unicode_ = 0;
+        hexDigits_ = 0;
+        state_ = inUnicode;
+      }
+      break;
+    case inNumber: {
+      const char* run = current;
+      while (run != endDoc && ((*run >= '0' && *run <= '9') ||
+                               in(*run, '.', 'e', 'E', '+', '-')))
+        ++run;
+      token_.append(current, run);
+      current = run;
+      if (current != endDoc) // the number ends before this byte
+        endNumber(offsetOf(current));
+      break;
+    }
+    case inLiteral:
+      if (*current != literal_[matched_]) {
+        fail("Syntax error: value, object or array expected.", tokenStart_);
+        break;
+      }
+      ++current;
+      if (literal_[++matched_] == 0) {
+        Value& target = *slot_;
+        if (literal_[0] == 't')
+          target = true;
+        else if (literal_[0] == 'f')
+          target = false;
+        else
+          target = Value();
+        storeOffsets(target, tokenStart_, offsetOf(current));
+        endValue();
+      }
+      break;
+    case inCommentStart:
+      if (*current != '*' && *current != '/') {
+        fail("Syntax error: '/' must start a comment.", offsetOf(current));
+        break;
+      }
+      state_ = *current++ == '*' ? inBlockComment : inLineComment;
+      break;
+    case inLineComment:
+      while (current != endDoc && *current != '\n' && *current != '\r')
+        ++current;
+      if (current != endDoc) {
+        ++current;
+        state_ = resume_;
+      }
+      break;
+    case inBlockComment:
+      while (current != endDoc && *current != '*')
+        ++current;
+      if (current != endDoc) {
+        ++current;
+        state_ = inBlockCommentEnd;
+      }
+      break;
+    case inBlockCommentEnd: {
+      Reader::Char c = *current++;
+      if (c == '/')
+        state_ = resume_;
+      else if (c != '*')
+        state_ = inBlockComment;
+      break;
+    }
+    default:
+      readStructural(current, endDoc);
+      break;
+    }
+  }
+  offset_ += current - beginDoc;
+  return current;
+}
+
+bool IncrementalReader::finish() {
+  if (state_ == inNumber && nodes_.empty())
+    endNumber(offset_);
+  if (state_ == stateDone)
+    return true;
+  if (state_ != stateFailed)
+    fail(state_ == expectValue && nodes_.empty()
+             ? "Syntax error: value, object or array expected."
+             : "Unexpected end of input",
+         offset_);
+  return false;
+}
+
+bool IncrementalReader::done() const { return state_ == stateDone; }
+
+bool IncrementalReader::failed() const { return state_ == stateFailed; }
+
+std::string IncrementalReader::getFormattedErrorMessages() const {
+  if (state_ != stateFailed)
+    return "";
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "Byte %lu", (unsigned long)errorOffset_);
+  return "* " + std::string(buffer) + "\n  " + error_ + "\n";
+}
+
+/// Handles a byte between tokens: whitespace, comments, punctuation and the
+/// first byte of a value.
+void IncrementalReader::readStructural(const char*& current, const char* end) {
+  current = skipWhitespace(current, end);
+  if (current == end)
+    return;
+  Reader::Char c = *current;
+  if (c == '/' && features_.allowComments_) {
+    resume_ = state_;
+    state_ = inCommentStart;
+    ++current;
+    return;
+  }
+  switch (state_) {
+  case expectValueOrArrayEnd:
+    if (c == ']') {
+      closeContainer(offsetOf(++current));
+      return;
+    }
+    startValue(current);
+    return;
+  case expectValue:
+    startValue(current);
+    return;
+  case expectNameOrObjectEnd:
+    if (c == '}') {
+      closeContainer(offsetOf(++current));
+      return;
+    }
+  // Else, fall through...
+  case expectName:
+    if (c != '"') {
+      fail("Missing '}' or object member name", offsetOf(current));
+      return;
+    }
+    token_.clear();
+    stringIsName_ = true;
+    state_ = inString;
+    ++current;
+    return;
+  case expectColon: {
+    if (c != ':') {
+      fail("Missing ':' after object member name", offsetOf(current));
+      return;
+    }
+    ++current;
+    // The member is created now, so a repeated name keeps the last value.
+    Value& object = *nodes_.back();
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+    const char* canonical = StaticKey::find(name_.c_str());
+    slot_ = canonical ? &object.resolveReference(
+                            canonical, Value::CZString::noDuplication, true)
+                      : &object[name_];
+#else
+    slot_ = &object[name_];
+#endif
+    state_ = expectValue;
+    return;
+  }
+  case expectSeparator: {
+    bool isArray = nodes_.back()->type() == arrayValue;
+    if (c == ',') {
+      state_ = isArray ? expectValue : expectName;
+      ++current;
+    } else if (c == (isArray ? ']' : '}')) {
+      closeContainer(offsetOf(++current));
+    } else {
+      fail(isArray ? "Missing ',' or ']' in array declaration"
+                   : "Missing ',' or '}' in object declaration",
+           offsetOf(current));
+    }
+    return;
+  }
+  default: // token states are handled by feed()
+    break;
+  }
+}
+
+void IncrementalReader::startValue(const char*& current) {
+  Reader::Char c = *current;
+  size_t start = offsetOf(current);
+  if (features_.strictRoot_ && nodes_.empty() && c != '{' && c != '[') {
+    fail("A valid JSON document must be either an array or an object value.",
+         start);
+    return;
+  }
+  switch (c) {
+  case '{':
+  case '[': {
+    Value& target = nextSlot();
+    target = Value(c == '{' ? objectValue : arrayValue);
+    if (features_.storeOffsets_)
+      target.setOffsetStart(start);
+    nodes_.push_back(&target);
+    state_ = c == '{' ? expectNameOrObjectEnd : expectValueOrArrayEnd;
+    break;
+  }
+  case '"':
+    slot_ = &nextSlot();
+    token_.clear();
+    stringIsName_ = false;
+    state_ = inString;
+    break;
+  case '-':
+  case '0':
+  case '1':
+  case '2':
+  case '3':
+  case '4':
+  case '5':
+  case '6':
+  case '7':
+  case '8':
+  case '9':
+    slot_ = &nextSlot();
+    token_.assign(1, c);
+    state_ = inNumber;
+    break;
+  case 't':
+  case 'f':
+  case 'n':
+    slot_ = &nextSlot();
+    literal_ = c == 't' ? "true" : c == 'f' ? "false" : "null";
+    matched_ = 1;
+    state_ = inLiteral;
+    break;
+  default:
+    fail("Syntax error: value, object or array expected.", start);
+    return;
+  }
+  tokenStart_ = start;
+  ++current;
+}
+
+void IncrementalReader::endString(size_t limit) {
+  if (stringIsName_) {
+    name_.swap(token_);
+    state_ = expectColon;
+    return;
+  }
+  Value& target = *slot_;
+  target = token_;
+  storeOffsets(target, tokenStart_, limit);
+  endValue();
+}
+
+void IncrementalReader::endNumber(size_t limit) {
+  Reader::Location begin = token_.data();
+  Reader::Location end = begin + token_.size();
+  Value& target = *slot_;
+  bool isNegative;
+  Value::LargestUInt value;
+  double real = 0;
+  if (decodeInteger(begin, end, isNegative, value))
+    storeInteger(target, isNegative, value);
+  else if (decodeReal(begin, end, real))
+    target = real;
+  else {
+    fail("'" + token_ + "' is not a number.", tokenStart_);
+    return;
+  }
+  storeOffsets(target, tokenStart_, limit);
+  endValue();
+}
+
+void IncrementalReader::endUnicode() {
+  if (highSurrogate_) {
+    token_ += codePointToUTF8(0x10000 + ((highSurrogate_ & 0x3FF) << 10) +
+                              (unicode_ & 0x3FF));
+    highSurrogate_ = 0;
+  } else if (unicode_ >= 0xD800 && unicode_ <= 0xDBFF) {
+    highSurrogate_ = unicode_;
+    state_ = inSurrogateEscape;
+    return;
+  } else {
+    token_ += codePointToUTF8(unicode_);
+  }
+  state_ = inString;
+}
+
+void IncrementalReader::closeContainer(size_t limit) {
+  if (features_.storeOffsets_)
+    nodes_.back()->setOffsetLimit(limit);
+  nodes_.pop_back();
+  endValue();
+}
+
+void IncrementalReader::endValue() {
+  state_ = nodes_.empty() ? stateDone : expectSeparator;
+}
+
+/// Where the value that starts now is stored: a new element when inside an
+/// array, otherwise the member resolved at the colon, or the root.
+Value& IncrementalReader::nextSlot() {
+  if (!nodes_.empty() && nodes_.back()->type() == arrayValue)
+    return nodes_.back()->append(Value());
+  return *slot_;
+}
+
+void IncrementalReader::fail(const std::string& message, size_t offset) {
+  error_ = message;
+  errorOffset_ = offset;
+  state_ = stateFailed;
+}
+
+void
+IncrementalReader::storeOffsets(Value& value, size_t start, size_t limit) {
+  if (features_.storeOffsets_) {
+    value.setOffsetStart(start);
+    value.setOffsetLimit(limit);
+  }
+}
+
+size_t IncrementalReader::offsetOf(const char* location) const {
+  return offset_ + (location - chunk_);
+}
+
 std::istream& operator>>(std::istream& sin, Value& root) {
   Json::Reader reader;
   bool ok = reader.parse(sin, root, true);
@@ -1195,7 +1925,7 @@ namespace Json {
 
 ValueIteratorBase::ValueIteratorBase()
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-    : current_(), isNull_(true) {
+    : current_(), array_(0), index_(0), isNull_(true) {
 }
 #else
     : isArray_(true), isNull_(true) {
@@ -1206,7 +1936,11 @@ ValueIteratorBase::ValueIteratorBase()
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
 ValueIteratorBase::ValueIteratorBase(
     const Value::ObjectValues::iterator& current)
-    : current_(current), isNull_(false) {}
+    : current_(current), array_(0), index_(0), isNull_(false) {}
+
+ValueIteratorBase::ValueIteratorBase(Value::ArrayValues* array,
+                                     ArrayIndex index)
+    : current_(), array_(array), index_(index), isNull_(false) {}
 #else
 ValueIteratorBase::ValueIteratorBase(
     const ValueInternalArray::IteratorState& state)
@@ -1223,6 +1957,8 @@ ValueIteratorBase::ValueIteratorBase(
 
 Value& ValueIteratorBase::deref() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (array_)
+    return (*array_)[index_];
   return current_->second;
 #else
   if (isArray_)
@@ -1233,7 +1969,10 @@ Value& ValueIteratorBase::deref() const {
 
 void ValueIteratorBase::increment() {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  ++current_;
+  if (array_)
+    ++index_;
+  else
+    ++current_;
 #else
   if (isArray_)
     ValueInternalArray::increment(iterator_.array_);
@@ -1243,7 +1982,10 @@ void ValueIteratorBase::increment() {
 
 void ValueIteratorBase::decrement() {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  --current_;
+  if (array_)
+    --index_;
+  else
+    --current_;
 #else
   if (isArray_)
     ValueInternalArray::decrement(iterator_.array_);
@@ -1265,6 +2007,9 @@ ValueIteratorBase::computeDistance(const SelfType& other) const {
   if (isNull_ && other.isNull_) {
     return 0;
   }
+  // Same orientation as the map walk below: steps from *this to other.
+  if (array_)
+    return difference_type(other.index_) - difference_type(index_);
 
   // Usage of std::distance is not portable (does not compile with Sun Studio 12
   // RogueWave STL,
@@ -1291,6 +2036,8 @@ bool ValueIteratorBase::isEqual(const SelfType& other) const {
   if (isNull_) {
     return other.isNull_;
   }
+  if (array_ || other.array_)
+    return array_ == other.array_ && index_ == other.index_;
   return current_ == other.current_;
 #else
   if (isArray_)
@@ -1302,6 +2049,8 @@ bool ValueIteratorBase::isEqual(const SelfType& other) const {
 void ValueIteratorBase::copy(const SelfType& other) {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   current_ = other.current_;
+  array_ = other.array_;
+  index_ = other.index_;
   isNull_ = other.isNull_;
 #else
   if (isArray_)
@@ -1312,6 +2061,8 @@ void ValueIteratorBase::copy(const SelfType& other) {
 
 Value ValueIteratorBase::key() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (array_)
+    return Value(index_);
   const Value::CZString czstring = (*current_).first;
   if (czstring.c_str()) {
     if (czstring.isStaticString())
@@ -1332,6 +2083,8 @@ Value ValueIteratorBase::key() const {
 
 UInt ValueIteratorBase::index() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (array_)
+    return index_;
   const Value::CZString czstring = (*current_).first;
   if (!czstring.c_str())
     return czstring.index();
@@ -1345,6 +2098,8 @@ UInt ValueIteratorBase::index() const {
 
 const char* ValueIteratorBase::memberName() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (array_)
+    return "";
   const char* name = (*current_).first.c_str();
   return name ? name : "";
 #else
@@ -1368,6 +2123,10 @@ ValueConstIterator::ValueConstIterator() {}
 ValueConstIterator::ValueConstIterator(
     const Value::ObjectValues::iterator& current)
     : ValueIteratorBase(current) {}
+
+ValueConstIterator::ValueConstIterator(Value::ArrayValues* array,
+                                       ArrayIndex index)
+    : ValueIteratorBase(array, index) {}
 #else
 ValueConstIterator::ValueConstIterator(
     const ValueInternalArray::IteratorState& state)
@@ -1397,6 +2156,9 @@ ValueIterator::ValueIterator() {}
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
 ValueIterator::ValueIterator(const Value::ObjectValues::iterator& current)
     : ValueIteratorBase(current) {}
+
+ValueIterator::ValueIterator(Value::ArrayValues* array, ArrayIndex index)
+    : ValueIteratorBase(array, index) {}
 #else
 ValueIterator::ValueIterator(const ValueInternalArray::IteratorState& state)
     : ValueIteratorBase(state) {}
@@ -1449,6 +2211,13 @@ ValueIterator& ValueIterator::operator=(const SelfType& other) {
 #include <utility>
 #include <cstring>
 #include <cassert>
+#include <new>
+#if JSON_HAS_RVALUE_REFERENCES
+#include <tuple>
+#endif
+#if JSON_INTERN_KEYS
+#include <atomic>
+#endif
 #ifdef JSON_USE_CPPTL
 #include <cpptl/conststring.h>
 #endif
@@ -1539,6 +2308,78 @@ static inline char* duplicateStringValue(const char* value,
  */
 static inline void releaseStringValue(char* value) { free(value); }
 
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class StaticKey
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+#if JSON_INTERN_KEYS
+// Open-addressing set of canonical member names. Entries are published with
+// a compare-and-swap and never removed, so lookups need no lock and an
+// interned pointer stays valid for the life of the process. Only StaticKey
+// adds names; the readers merely look up the names they parse, so input
+// never grows the table. Short names only, and the table stops growing at
+// half load.
+static const unsigned int internTableSize = 1024; // power of two
+static const unsigned int internMaxLength = 64;
+static std::atomic<const char*> internTable[internTableSize];
+static std::atomic<unsigned int> internCount;
+
+/// Canonical copy of \a name, or 0 when it is not (and, if \a insert is
+/// \c false, will not be) in the table.
+static const char* internString(const char* name, bool insert) {
+  unsigned int hash = 2166136261u; // FNV-1a
+  unsigned int length = 0;
+  for (; name[length]; ++length) {
+    if (length == internMaxLength)
+      return 0;
+    hash = (hash ^ (unsigned char)name[length]) * 16777619u;
+  }
+  for (unsigned int probe = 0; probe < internTableSize; ++probe) {
+    std::atomic<const char*>& slot =
+        internTable[(hash + probe) & (internTableSize - 1)];
+    const char* entry = slot.load(std::memory_order_acquire);
+    if (!entry) {
+      if (!insert ||
+          internCount.load(std::memory_order_relaxed) >= internTableSize / 2)
+        return 0;
+      char* copy = duplicateStringValue(name, length);
+      if (slot.compare_exchange_strong(entry, copy,
+                                       std::memory_order_acq_rel)) {
+        internCount.fetch_add(1, std::memory_order_relaxed);
+        return copy;
+      }
+      // Lost the race; entry now holds the winner, which may be this name.
+      releaseStringValue(copy);
+    }
+    if (strncmp(entry, name, length) == 0 && entry[length] == 0)
+      return entry;
+  }
+  return 0;
+}
+#endif // if JSON_INTERN_KEYS
+
+StaticKey::StaticKey(const char* name) : str_(name), interned_(false) {
+#if JSON_INTERN_KEYS
+  if (const char* canonical = internString(name, true)) {
+    str_ = canonical;
+    interned_ = true;
+  }
+#endif
+}
+
+const char* StaticKey::find(const char* name) {
+#if JSON_INTERN_KEYS
+  return internString(name, false);
+#else
+  (void)name;
+  return 0;
+#endif
+}
+
 } // namespace Json
 
 // //////////////////////////////////////////////////////////////////
@@ -1559,6 +2400,80 @@ static inline void releaseStringValue(char* value) { free(value); }
 
 namespace Json {
 
+#if JSON_USE_VALUE_ARENA
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class ValueArena
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+// Enough for every node type stored in a Value container.
+static const size_t kArenaAlignment = 8;
+
+ValueArena::ValueArena(size_t blockSize)
+    : blocks_(0), current_(0), end_(0), blockSize_(blockSize) {}
+
+ValueArena::~ValueArena() {
+  release();
+  free(blocks_);
+}
+
+void ValueArena::newBlock(size_t size) {
+  if (size < blockSize_)
+    size = blockSize_;
+  Block* block = static_cast<Block*>(malloc(sizeof(Block) + size));
+  JSON_ASSERT_MESSAGE(block != 0,
+                      "in Json::ValueArena::newBlock(): "
+                      "Failed to allocate arena block");
+  block->next_ = blocks_;
+  block->size_ = size;
+  blocks_ = block;
+  current_ = reinterpret_cast<char*>(block + 1);
+  end_ = current_ + size;
+}
+
+void* ValueArena::allocate(size_t size) {
+  size_t misalign = reinterpret_cast<size_t>(current_) & (kArenaAlignment - 1);
+  if (misalign)
+    current_ += kArenaAlignment - misalign;
+  if (current_ > end_ || size_t(end_ - current_) < size)
+    newBlock(size);
+  void* block = current_;
+  current_ += size;
+  return block;
+}
+
+char* ValueArena::duplicate(const char* value, size_t length) {
+  if (size_t(end_ - current_) < length + 1)
+    newBlock(length + 1);
+  char* newString = current_;
+  current_ += length + 1;
+  memcpy(newString, value, length);
+  newString[length] = 0;
+  return newString;
+}
+
+void ValueArena::release() {
+  if (!blocks_)
+    return;
+  // Keep the most recent block, unless it is an oversized one.
+  Block* keep = blocks_->size_ == blockSize_ ? blocks_ : 0;
+  Block* block = keep ? blocks_->next_ : blocks_;
+  while (block) {
+    Block* next = block->next_;
+    free(block);
+    block = next;
+  }
+  blocks_ = keep;
+  if (keep)
+    keep->next_ = 0;
+  current_ = keep ? reinterpret_cast<char*>(keep + 1) : 0;
+  end_ = keep ? current_ + keep->size_ : 0;
+}
+#endif // if JSON_USE_VALUE_ARENA
+
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
@@ -1611,6 +2526,13 @@ Value::CZString::CZString(const CZString& other)
                  ? (other.index_ == noDuplication ? noDuplication : duplicate)
                  : other.index_) {}
 
+#if JSON_HAS_RVALUE_REFERENCES
+Value::CZString::CZString(CZString&& other) noexcept
+    : cstr_(other.cstr_), index_(other.index_) {
+  other.cstr_ = 0;
+}
+#endif
+
 Value::CZString::~CZString() {
   if (cstr_ && index_ == duplicate)
     releaseStringValue(const_cast<char*>(cstr_));
@@ -1628,13 +2550,13 @@ Value::CZString& Value::CZString::operator=(CZString other) {
 
 bool Value::CZString::operator<(const CZString& other) const {
   if (cstr_)
-    return strcmp(cstr_, other.cstr_) < 0;
+    return cstr_ != other.cstr_ && strcmp(cstr_, other.cstr_) < 0;
   return index_ < other.index_;
 }
 
 bool Value::CZString::operator==(const CZString& other) const {
-  if (cstr_)
-    return strcmp(cstr_, other.cstr_) == 0;
+  if (cstr_) // interned names are equal by address
+    return cstr_ == other.cstr_ || strcmp(cstr_, other.cstr_) == 0;
   return index_ == other.index_;
 }
 
@@ -1654,12 +2576,36 @@ bool Value::CZString::isStaticString() const { return index_ == noDuplication; }
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+#if JSON_USE_VALUE_ARENA
+/// Container whose storage, and that of its elements, comes from \a arena.
+template <typename Container>
+static inline Container* newArenaContainer(ValueArena& arena) {
+  typedef typename Container::allocator_type Allocator;
+  return new (arena.allocate(sizeof(Container))) Container(Allocator(&arena));
+}
+
+template <typename Container>
+static inline void deleteContainer(Container* container) {
+  if (container->get_allocator().arena())
+    container->~Container(); // the memory goes with the arena
+  else
+    delete container;
+}
+#else
+template <typename Container>
+static inline void deleteContainer(Container* container) {
+  delete container;
+}
+#endif // if JSON_USE_VALUE_ARENA
+#endif // ifndef JSON_VALUE_USE_INTERNAL_MAP
+
 /*! \internal Default constructor initialization must be equivalent to:
  * memset( this, 0, sizeof(Value) )
  * This optimization is used in ValueInternalMap fast allocator.
  */
 Value::Value(ValueType type)
-    : type_(type), allocated_(false)
+    : type_(type), allocated_(false), internedKeys_(type == objectValue)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
@@ -1681,6 +2627,8 @@ Value::Value(ValueType type)
     break;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    value_.array_ = new ArrayValues();
+    break;
   case objectValue:
     value_.map_ = new ObjectValues();
     break;
@@ -1701,7 +2649,7 @@ Value::Value(ValueType type)
 }
 
 Value::Value(UInt value)
-    : type_(uintValue), allocated_(false)
+    : type_(uintValue), allocated_(false), internedKeys_(false)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
@@ -1712,7 +2660,7 @@ Value::Value(UInt value)
 }
 
 Value::Value(Int value)
-    : type_(intValue), allocated_(false)
+    : type_(intValue), allocated_(false), internedKeys_(false)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
@@ -1724,7 +2672,7 @@ Value::Value(Int value)
 
 #if defined(JSON_HAS_INT64)
 Value::Value(Int64 value)
-    : type_(intValue), allocated_(false)
+    : type_(intValue), allocated_(false), internedKeys_(false)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
@@ -1735,7 +2683,7 @@ Value::Value(Int64 value)
 }
 
 Value::Value(UInt64 value)
-    : type_(uintValue), allocated_(false)
+    : type_(uintValue), allocated_(false), internedKeys_(false)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
@@ -1747,7 +2695,7 @@ Value::Value(UInt64 value)
 #endif // defined(JSON_HAS_INT64)
 
 Value::Value(double value)
-    : type_(realValue), allocated_(false)
+    : type_(realValue), allocated_(false), internedKeys_(false)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
@@ -1758,7 +2706,7 @@ Value::Value(double value)
 }
 
 Value::Value(const char* value)
-    : type_(stringValue), allocated_(true)
+    : type_(stringValue), allocated_(true), internedKeys_(false)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
@@ -1769,7 +2717,7 @@ Value::Value(const char* value)
 }
 
 Value::Value(const char* beginValue, const char* endValue)
-    : type_(stringValue), allocated_(true)
+    : type_(stringValue), allocated_(true), internedKeys_(false)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
@@ -1780,8 +2728,42 @@ Value::Value(const char* beginValue, const char* endValue)
       duplicateStringValue(beginValue, (unsigned int)(endValue - beginValue));
 }
 
+#if JSON_USE_VALUE_ARENA
+Value::Value(ValueType type, ValueArena& arena)
+    : type_(type), allocated_(false), internedKeys_(type == objectValue)
+#ifdef JSON_VALUE_USE_INTERNAL_MAP
+      ,
+      itemIsUsed_(0)
+#endif
+      ,
+      comments_(0), start_(0), limit_(0) {
+  switch (type) {
+  case arrayValue:
+    value_.array_ = newArenaContainer<ArrayValues>(arena);
+    break;
+  case objectValue:
+    value_.map_ = newArenaContainer<ObjectValues>(arena);
+    break;
+  default:
+    Value(type).swap(*this);
+    break;
+  }
+}
+
+Value::Value(const char* beginValue, const char* endValue, ValueArena& arena)
+    : type_(stringValue), allocated_(false), internedKeys_(false)
+#ifdef JSON_VALUE_USE_INTERNAL_MAP
+      ,
+      itemIsUsed_(0)
+#endif
+      ,
+      comments_(0), start_(0), limit_(0) {
+  value_.string_ = arena.duplicate(beginValue, size_t(endValue - beginValue));
+}
+#endif // if JSON_USE_VALUE_ARENA
+
 Value::Value(const std::string& value)
-    : type_(stringValue), allocated_(true)
+    : type_(stringValue), allocated_(true), internedKeys_(false)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
@@ -1793,7 +2775,7 @@ Value::Value(const std::string& value)
 }
 
 Value::Value(const StaticString& value)
-    : type_(stringValue), allocated_(false)
+    : type_(stringValue), allocated_(false), internedKeys_(false)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
@@ -1805,7 +2787,7 @@ Value::Value(const StaticString& value)
 
 #ifdef JSON_USE_CPPTL
 Value::Value(const CppTL::ConstString& value)
-    : type_(stringValue), allocated_(true)
+    : type_(stringValue), allocated_(true), internedKeys_(false)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
@@ -1817,7 +2799,7 @@ Value::Value(const CppTL::ConstString& value)
 #endif
 
 Value::Value(bool value)
-    : type_(booleanValue), allocated_(false)
+    : type_(booleanValue), allocated_(false), internedKeys_(false)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
@@ -1828,7 +2810,8 @@ Value::Value(bool value)
 }
 
 Value::Value(const Value& other)
-    : type_(other.type_), allocated_(false)
+    : type_(other.type_), allocated_(false),
+      internedKeys_(other.internedKeys_)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
@@ -1854,6 +2837,8 @@ Value::Value(const Value& other)
     break;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    value_.array_ = new ArrayValues(*other.value_.array_);
+    break;
   case objectValue:
     value_.map_ = new ObjectValues(*other.value_.map_);
     break;
@@ -1878,6 +2863,24 @@ Value::Value(const Value& other)
   }
 }
 
+#if JSON_HAS_RVALUE_REFERENCES
+Value::Value(Value&& other) noexcept
+    : value_(other.value_), type_(other.type_), allocated_(other.allocated_),
+      internedKeys_(other.internedKeys_)
+#ifdef JSON_VALUE_USE_INTERNAL_MAP
+      ,
+      itemIsUsed_(0)
+#endif
+      ,
+      comments_(other.comments_), start_(other.start_), limit_(other.limit_) {
+  other.type_ = nullValue;
+  other.allocated_ = false;
+  other.comments_ = 0;
+  other.start_ = 0;
+  other.limit_ = 0;
+}
+#endif
+
 Value::~Value() {
   switch (type_) {
   case nullValue:
@@ -1892,8 +2895,10 @@ Value::~Value() {
     break;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    deleteContainer(value_.array_);
+    break;
   case objectValue:
-    delete value_.map_;
+    deleteContainer(value_.map_);
     break;
 #else
   case arrayValue:
@@ -1911,10 +2916,25 @@ Value::~Value() {
     delete[] comments_;
 }
 
+#if JSON_HAS_RVALUE_REFERENCES
+Value& Value::operator=(const Value& other) {
+  Value(other).swap(*this);
+  return *this;
+}
+
+Value& Value::operator=(Value&& other) noexcept {
+  // Taking other's payload before the swap keeps v = std::move(v["key"])
+  // from parking v's old tree inside one of its own members.
+  Value temp(std::move(other));
+  swap(temp);
+  return *this;
+}
+#else
 Value& Value::operator=(Value other) {
   swap(other);
   return *this;
 }
+#endif
 
 void Value::swap(Value& other) {
   ValueType temp = type_;
@@ -1924,6 +2944,9 @@ void Value::swap(Value& other) {
   int temp2 = allocated_;
   allocated_ = other.allocated_;
   other.allocated_ = temp2;
+  unsigned int temp3 = internedKeys_;
+  internedKeys_ = other.internedKeys_;
+  other.internedKeys_ = temp3;
   std::swap(start_, other.start_);
   std::swap(limit_, other.limit_);
 }
@@ -1958,7 +2981,12 @@ bool Value::operator<(const Value& other) const {
            (other.value_.string_ && value_.string_ &&
             strcmp(value_.string_, other.value_.string_) < 0);
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  case arrayValue:
+  case arrayValue: {
+    int delta = int(value_.array_->size() - other.value_.array_->size());
+    if (delta)
+      return delta < 0;
+    return (*value_.array_) < (*other.value_.array_);
+  }
   case objectValue: {
     int delta = int(value_.map_->size() - other.value_.map_->size());
     if (delta)
@@ -2008,6 +3036,7 @@ bool Value::operator==(const Value& other) const {
             strcmp(value_.string_, other.value_.string_) == 0);
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    return (*value_.array_) == (*other.value_.array_);
   case objectValue:
     return value_.map_->size() == other.value_.map_->size() &&
            (*value_.map_) == (*other.value_.map_);
@@ -2229,7 +3258,7 @@ bool Value::isConvertibleTo(ValueType other) const {
     return (isNumeric() && asDouble() == 0.0) ||
            (type_ == booleanValue && value_.bool_ == false) ||
            (type_ == stringValue && asString() == "") ||
-           (type_ == arrayValue && value_.map_->size() == 0) ||
+           (type_ == arrayValue && value_.array_->size() == 0) ||
            (type_ == objectValue && value_.map_->size() == 0) ||
            type_ == nullValue;
   case intValue:
@@ -2267,13 +3296,8 @@ ArrayIndex Value::size() const {
   case stringValue:
     return 0;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  case arrayValue: // size of the array is highest index + 1
-    if (!value_.map_->empty()) {
-      ObjectValues::const_iterator itLast = value_.map_->end();
-      --itLast;
-      return (*itLast).first.index() + 1;
-    }
-    return 0;
+  case arrayValue:
+    return ArrayIndex(value_.array_->size());
   case objectValue:
     return ArrayIndex(value_.map_->size());
 #else
@@ -2303,19 +3327,13 @@ void Value::clear() {
   start_ = 0;
   limit_ = 0;
   switch (type_) {
-#ifndef JSON_VALUE_USE_INTERNAL_MAP
-  case arrayValue:
-  case objectValue:
-    value_.map_->clear();
-    break;
-#else
   case arrayValue:
     value_.array_->clear();
     break;
   case objectValue:
     value_.map_->clear();
+    internedKeys_ = true;
     break;
-#endif
   default:
     break;
   }
@@ -2326,21 +3344,10 @@ void Value::resize(ArrayIndex newSize) {
                       "in Json::Value::resize(): requires arrayValue");
   if (type_ == nullValue)
     *this = Value(arrayValue);
-#ifndef JSON_VALUE_USE_INTERNAL_MAP
-  ArrayIndex oldSize = size();
   if (newSize == 0)
     clear();
-  else if (newSize > oldSize)
-    (*this)[newSize - 1];
-  else {
-    for (ArrayIndex index = newSize; index < oldSize; ++index) {
-      value_.map_->erase(index);
-    }
-    assert(size() == newSize);
-  }
-#else
-  value_.array_->resize(newSize);
-#endif
+  else
+    value_.array_->resize(newSize);
 }
 
 Value& Value::operator[](ArrayIndex index) {
@@ -2350,14 +3357,11 @@ Value& Value::operator[](ArrayIndex index) {
   if (type_ == nullValue)
     *this = Value(arrayValue);
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString key(index);
-  ObjectValues::iterator it = value_.map_->lower_bound(key);
-  if (it != value_.map_->end() && (*it).first == key)
-    return (*it).second;
-
-  ObjectValues::value_type defaultValue(key, null);
-  it = value_.map_->insert(it, defaultValue);
-  return (*it).second;
+  // Writing past the end fills the gap with nulls, as the map-backed array
+  // reported them.
+  if (index >= value_.array_->size())
+    value_.array_->resize(index + 1);
+  return (*value_.array_)[index];
 #else
   return value_.array_->resolveReference(index);
 #endif
@@ -2377,11 +3381,9 @@ const Value& Value::operator[](ArrayIndex index) const {
   if (type_ == nullValue)
     return null;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString key(index);
-  ObjectValues::const_iterator it = value_.map_->find(key);
-  if (it == value_.map_->end())
+  if (index >= value_.array_->size())
     return null;
-  return (*it).second;
+  return (*value_.array_)[index];
 #else
   Value* value = value_.array_->find(index);
   return value ? *value : null;
@@ -2400,26 +3402,82 @@ Value& Value::operator[](const char* key) {
 }
 
 Value& Value::resolveReference(const char* key, bool isStatic) {
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  return resolveReference(
+      key, isStatic ? CZString::noDuplication : CZString::duplicate, false);
+#else
   JSON_ASSERT_MESSAGE(
       type_ == nullValue || type_ == objectValue,
       "in Json::Value::resolveReference(): requires objectValue");
   if (type_ == nullValue)
     *this = Value(objectValue);
+  return value_.map_->resolveReference(key, isStatic);
+#endif
+}
+
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString actualKey(
-      key, isStatic ? CZString::noDuplication : CZString::duplicateOnCopy);
+Value& Value::resolveReference(const char* key,
+                               CZString::DuplicationPolicy policy,
+                               bool interned) {
+  JSON_ASSERT_MESSAGE(
+      type_ == nullValue || type_ == objectValue,
+      "in Json::Value::resolveReference(): requires objectValue");
+  if (type_ == nullValue)
+    *this = Value(objectValue);
+  CZString actualKey(key, CZString::noDuplication);
   ObjectValues::iterator it = value_.map_->lower_bound(actualKey);
   if (it != value_.map_->end() && (*it).first == actualKey)
     return (*it).second;
 
-  ObjectValues::value_type defaultValue(actualKey, null);
-  it = value_.map_->insert(it, defaultValue);
-  Value& value = (*it).second;
-  return value;
+  if (!interned)
+    internedKeys_ = false;
+#if JSON_USE_VALUE_ARENA
+  if (policy == CZString::duplicate) {
+    if (ValueArena* arena = value_.map_->get_allocator().arena()) {
+      // The name lives in the arena too; duplicateOnCopy keeps it from being
+      // freed while still giving copies of the map their own heap names.
+      key = arena->duplicate(key, strlen(key));
+      policy = CZString::duplicateOnCopy;
+    }
+  }
+#endif
+#if JSON_HAS_RVALUE_REFERENCES
+  // Built in place: the name is duplicated at most once.
+  it = value_.map_->emplace_hint(it,
+                                 std::piecewise_construct,
+                                 std::forward_as_tuple(key, policy),
+                                 std::forward_as_tuple());
 #else
-  return value_.map_->resolveReference(key, isStatic);
+  // The pair is copied into the map, which already duplicates the name
+  // unless it is static.
+  CZString name(key,
+                policy == CZString::noDuplication ? CZString::noDuplication
+                                                  : CZString::duplicateOnCopy);
+  ObjectValues::value_type defaultValue(name, null);
+  it = value_.map_->insert(it, defaultValue);
 #endif
+  return (*it).second;
+}
+
+/// Objects up to this size are searched by address before falling back to
+/// the name comparisons of the map.
+static const size_t maxScannedMembers = 8;
+
+const Value* Value::findMember(const StaticKey& key) const {
+  if (key.isInterned() && value_.map_->size() <= maxScannedMembers) {
+    for (ObjectValues::const_iterator it = value_.map_->begin();
+         it != value_.map_->end();
+         ++it)
+      if ((*it).first.c_str() == key.c_str())
+        return &(*it).second;
+    if (internedKeys_)
+      return 0;
+  }
+  ObjectValues::const_iterator it =
+      value_.map_->find(CZString(key.c_str(), CZString::noDuplication));
+  return it == value_.map_->end() ? 0 : &(*it).second;
 }
+#endif // ifndef JSON_VALUE_USE_INTERNAL_MAP
 
 Value Value::get(ArrayIndex index, const Value& defaultValue) const {
   const Value* value = &((*this)[index]);
@@ -2458,6 +3516,33 @@ Value& Value::operator[](const StaticString& key) {
   return resolveReference(key, true);
 }
 
+Value& Value::operator[](const StaticKey& key) {
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (type_ == objectValue) {
+    if (const Value* value = findMember(key))
+      return const_cast<Value&>(*value);
+  }
+  return resolveReference(
+      key.c_str(), CZString::noDuplication, key.isInterned());
+#else
+  return resolveReference(key.c_str(), true);
+#endif
+}
+
+const Value& Value::operator[](const StaticKey& key) const {
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  JSON_ASSERT_MESSAGE(
+      type_ == nullValue || type_ == objectValue,
+      "in Json::Value::operator[](StaticKey)const: requires objectValue");
+  if (type_ == nullValue)
+    return null;
+  const Value* value = findMember(key);
+  return value ? *value : null;
+#else
+  return (*this)[key.c_str()];
+#endif
+}
+
 #ifdef JSON_USE_CPPTL
 Value& Value::operator[](const CppTL::ConstString& key) {
   return (*this)[key.c_str()];
@@ -2468,7 +3553,33 @@ const Value& Value::operator[](const CppTL::ConstString& key) const {
 }
 #endif
 
-Value& Value::append(const Value& value) { return (*this)[size()] = value; }
+Value& Value::append(const Value& value) {
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue,
+                      "in Json::Value::append(): requires arrayValue");
+  if (type_ == nullValue)
+    *this = Value(arrayValue);
+  value_.array_->push_back(value);
+  return value_.array_->back();
+#else
+  return (*this)[size()] = value;
+#endif
+}
+
+#if JSON_HAS_RVALUE_REFERENCES
+Value& Value::append(Value&& value) {
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue,
+                      "in Json::Value::append(): requires arrayValue");
+  if (type_ == nullValue)
+    *this = Value(arrayValue);
+  value_.array_->push_back(std::move(value));
+  return value_.array_->back();
+#else
+  return (*this)[size()] = std::move(value);
+#endif
+}
+#endif
 
 Value Value::get(const char* key, const Value& defaultValue) const {
   const Value* value = &((*this)[key]);
@@ -2489,7 +3600,18 @@ Value Value::removeMember(const char* key) {
   ObjectValues::iterator it = value_.map_->find(actualKey);
   if (it == value_.map_->end())
     return null;
+#if JSON_USE_VALUE_ARENA
+  // A member of an arena document is copied out so that the result does not
+  // depend on the arena; otherwise its payload is simply taken over.
+  if (value_.map_->get_allocator().arena()) {
+    Value old(it->second);
+    value_.map_->erase(it);
+    return old;
+  }
+  Value old(std::move(it->second));
+#else
   Value old(it->second);
+#endif
   value_.map_->erase(it);
   return old;
 #else
@@ -2524,6 +3646,11 @@ bool Value::isMember(const std::string& key) const {
   return isMember(key.c_str());
 }
 
+bool Value::isMember(const StaticKey& key) const {
+  const Value* value = &((*this)[key]);
+  return value != &null;
+}
+
 #ifdef JSON_USE_CPPTL
 bool Value::isMember(const CppTL::ConstString& key) const {
   return isMember(key.c_str());
@@ -2728,6 +3855,9 @@ Value::const_iterator Value::begin() const {
     break;
 #else
   case arrayValue:
+    if (value_.array_)
+      return const_iterator(value_.array_, 0);
+    break;
   case objectValue:
     if (value_.map_)
       return const_iterator(value_.map_->begin());
@@ -2758,6 +3888,9 @@ Value::const_iterator Value::end() const {
     break;
 #else
   case arrayValue:
+    if (value_.array_)
+      return const_iterator(value_.array_, ArrayIndex(value_.array_->size()));
+    break;
   case objectValue:
     if (value_.map_)
       return const_iterator(value_.map_->end());
@@ -2788,6 +3921,9 @@ Value::iterator Value::begin() {
     break;
 #else
   case arrayValue:
+    if (value_.array_)
+      return iterator(value_.array_, 0);
+    break;
   case objectValue:
     if (value_.map_)
       return iterator(value_.map_->begin());
@@ -2818,6 +3954,9 @@ Value::iterator Value::end() {
     break;
 #else
   case arrayValue:
+    if (value_.array_)
+      return iterator(value_.array_, ArrayIndex(value_.array_->size()));
+    break;
   case objectValue:
     if (value_.map_)
       return iterator(value_.map_->end());
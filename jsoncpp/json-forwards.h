@@ -172,6 +172,27 @@ license you like.
 #define JSONCPP_DEPRECATED(message)
 #endif // if !defined(JSONCPP_DEPRECATED)
 
+/// If non-zero, Value gets C++11 move operations.
+#if !defined(JSON_HAS_RVALUE_REFERENCES)
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1600)
+#define JSON_HAS_RVALUE_REFERENCES 1
+#else
+#define JSON_HAS_RVALUE_REFERENCES 0
+#endif
+#endif // if !defined(JSON_HAS_RVALUE_REFERENCES)
+
+/// If non-zero, Reader can carve documents from a ValueArena. Needs the C++11
+/// allocator model (select_on_container_copy_construction).
+#if !defined(JSON_USE_VALUE_ARENA)
+#define JSON_USE_VALUE_ARENA JSON_HAS_RVALUE_REFERENCES
+#endif
+
+/// If non-zero, StaticKey names are interned so that StaticKey lookups compare
+/// pointers. Needs std::atomic to share the intern table between threads.
+#if !defined(JSON_INTERN_KEYS)
+#define JSON_INTERN_KEYS JSON_HAS_RVALUE_REFERENCES
+#endif
+
 namespace Json {
 typedef int Int;
 typedef unsigned int UInt;
@@ -229,6 +250,7 @@ class StyledWriter;
 
 // reader.h
 class Reader;
+class IncrementalReader;
 
 // features.h
 class Features;
@@ -236,12 +258,16 @@ class Features;
 // value.h
 typedef unsigned int ArrayIndex;
 class StaticString;
+class StaticKey;
 class Path;
 class PathArgument;
 class Value;
 class ValueIteratorBase;
 class ValueIterator;
 class ValueConstIterator;
+#if JSON_USE_VALUE_ARENA
+class ValueArena;
+#endif
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
 class ValueMapAllocator;
 class ValueInternalLink;
@@ -199,6 +199,27 @@ license you like.
 #define JSONCPP_DEPRECATED(message)
 #endif // if !defined(JSONCPP_DEPRECATED)
 
+/// If non-zero, Value gets C++11 move operations.
+#if !defined(JSON_HAS_RVALUE_REFERENCES)
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1600)
+#define JSON_HAS_RVALUE_REFERENCES 1
+#else
+#define JSON_HAS_RVALUE_REFERENCES 0
+#endif
+#endif // if !defined(JSON_HAS_RVALUE_REFERENCES)
+
+/// If non-zero, Reader can carve documents from a ValueArena. Needs the C++11
+/// allocator model (select_on_container_copy_construction).
+#if !defined(JSON_USE_VALUE_ARENA)
+#define JSON_USE_VALUE_ARENA JSON_HAS_RVALUE_REFERENCES
+#endif
+
+/// If non-zero, StaticKey names are interned so that StaticKey lookups compare
+/// pointers. Needs std::atomic to share the intern table between threads.
+#if !defined(JSON_INTERN_KEYS)
+#define JSON_INTERN_KEYS JSON_HAS_RVALUE_REFERENCES
+#endif
+
 namespace Json {
 typedef int Int;
 typedef unsigned int UInt;
@@ -256,6 +277,7 @@ class StyledWriter;
 
 // reader.h
 class Reader;
+class IncrementalReader;
 
 // features.h
 class Features;
@@ -263,12 +285,16 @@ class Features;
 // value.h
 typedef unsigned int ArrayIndex;
 class StaticString;
+class StaticKey;
 class Path;
 class PathArgument;
 class Value;
 class ValueIteratorBase;
 class ValueIterator;
 class ValueConstIterator;
+#if JSON_USE_VALUE_ARENA
+class ValueArena;
+#endif
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
 class ValueMapAllocator;
 class ValueInternalLink;
@@ -329,6 +355,14 @@ public:
    */
   static Features strictMode();
 
+  /** \brief A configuration for trusted, machine-generated input.
+   * - Comments are forbidden.
+   * - Root object can be any JSON value
+   * - Values do not record their offsets in the document.
+   * - The reader stops at the first error and only keeps its position.
+   */
+  static Features trusted();
+
   /** \brief Initialize the configuration like JsonConfig::allFeatures;
    */
   Features();
@@ -345,6 +379,15 @@ public:
 
   /// \c true if numeric object key are allowed. Default: \c false.
   bool allowNumericKeys_;
+
+  /// \c true if values record their [start, limit) offsets in the document
+  /// (see Value::getOffsetStart()). Default: \c true.
+  bool storeOffsets_;
+
+  /// \c true if errors are collected with a message each, and the reader
+  /// recovers to report further ones. \c false stops at the first error and
+  /// keeps only where it occurred. Default: \c true.
+  bool collectErrors_;
 };
 
 } // namespace Json
@@ -450,6 +493,146 @@ private:
   const char* str_;
 };
 
+/** \brief Member name prepared for repeated lookups.
+ *
+ * The constructor hashes the name once and maps it to a canonical copy, the
+ * same one the Reader stores for members of that name. Looking the key up in
+ * a parsed object then compares addresses instead of strings, and inserting
+ * it never duplicates the name.
+ *
+ * Only keys add names to the intern table; the readers look up every name
+ * they parse but never insert one. Create the keys before parsing, or the
+ * parsed names are stored as plain strings and lookups fall back to string
+ * comparison.
+ *
+ * Example of usage:
+ * \code
+ * static const Json::StaticKey history("history");
+ * const Json::Value& h = request[history];
+ * \endcode
+ *
+ * Names that cannot be interned (too long, or the table is full) are kept as
+ * given and looked up by string comparison, so, as with StaticString, \a name
+ * must outlive the key.
+ */
+class JSON_API StaticKey {
+public:
+  explicit StaticKey(const char* name);
+
+  const char* c_str() const { return str_; }
+
+  /// \c true if c_str() is the canonical copy of the name.
+  bool isInterned() const { return interned_; }
+
+  /// Canonical copy of \a name if a key of that name exists, else 0. Never
+  /// adds \a name to the table.
+  static const char* find(const char* name);
+
+private:
+  const char* str_;
+  bool interned_;
+};
+
+#if JSON_USE_VALUE_ARENA
+/** \brief Bump allocator for the nodes, member names and strings of a
+ * document.
+ *
+ * Reader::parse() can carve a whole document out of an arena: the object and
+ * array storage, the member names and the string values are taken from a few
+ * large blocks, and are freed together by release() or by the destructor.
+ * Values never free arena memory themselves, and copying a Value out of an
+ * arena document always yields ordinary heap storage.
+ *
+ * The arena must outlive every Value that still refers to it; declare it
+ * before the root Value.
+ *
+ * Example of usage:
+ * \code
+ * Json::ValueArena arena;
+ * Json::Value root;
+ * Json::Reader reader;
+ * reader.parse(doc.data(), doc.data() + doc.size(), root, arena);
+ * \endcode
+ */
+class JSON_API ValueArena {
+public:
+  explicit ValueArena(size_t blockSize = 8192);
+  ~ValueArena();
+
+  /// Returns \a size bytes aligned for any Value node.
+  void* allocate(size_t size);
+
+  /// Zero-terminated copy of [value, value + length).
+  char* duplicate(const char* value, size_t length);
+
+  /// Frees everything at once, keeping the current block for reuse. Values
+  /// built from the arena must already be gone.
+  void release();
+
+private:
+  ValueArena(const ValueArena&);
+  ValueArena& operator=(const ValueArena&);
+
+  struct Block {
+    Block* next_;
+    size_t size_;
+  };
+
+  void newBlock(size_t size);
+
+  Block* blocks_;
+  char* current_;
+  char* end_;
+  size_t blockSize_;
+};
+
+/** \brief Allocator of the Value containers.
+ *
+ * Uses the heap unless it was given a ValueArena. A container copy always
+ * goes back to the heap, so that copies outlive the arena.
+ */
+template <typename T> class ValueAllocator {
+public:
+  typedef T value_type;
+
+  ValueAllocator() : arena_(0) {}
+  explicit ValueAllocator(ValueArena* arena) : arena_(arena) {}
+  template <typename U>
+  ValueAllocator(const ValueAllocator<U>& other)
+      : arena_(other.arena()) {}
+
+  T* allocate(size_t count) {
+    if (arena_)
+      return static_cast<T*>(arena_->allocate(count * sizeof(T)));
+    return static_cast<T*>(::operator new(count * sizeof(T)));
+  }
+
+  void deallocate(T* pointer, size_t) {
+    if (!arena_)
+      ::operator delete(pointer);
+  }
+
+  ValueAllocator select_on_container_copy_construction() const {
+    return ValueAllocator();
+  }
+
+  ValueArena* arena() const { return arena_; }
+
+private:
+  ValueArena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ValueAllocator<T>& a, const ValueAllocator<U>& b) {
+  return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ValueAllocator<T>& a, const ValueAllocator<U>& b) {
+  return a.arena() != b.arena();
+}
+#endif // if JSON_USE_VALUE_ARENA
+
 /** \brief Represents a <a HREF="http://www.json.org">JSON</a> value.
  *
  * This class is a discriminated union wrapper that can represents a:
@@ -481,6 +664,8 @@ private:
  */
 class JSON_API Value {
   friend class ValueIteratorBase;
+  friend class Reader;
+  friend class IncrementalReader;
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   friend class ValueInternalLink;
   friend class ValueInternalMap;
@@ -536,6 +721,9 @@ private:
     CZString(ArrayIndex index);
     CZString(const char* cstr, DuplicationPolicy allocate);
     CZString(const CZString& other);
+#if JSON_HAS_RVALUE_REFERENCES
+    CZString(CZString&& other) noexcept;
+#endif
     ~CZString();
     CZString& operator=(CZString other);
     bool operator<(const CZString& other) const;
@@ -551,11 +739,25 @@ private:
   };
 
 public:
+#if JSON_USE_VALUE_ARENA
+  typedef std::map<CZString,
+                   Value,
+                   std::less<CZString>,
+                   ValueAllocator<std::pair<const CZString, Value> > >
+      ObjectValues;
+  /// Elements of an arrayValue, stored contiguously so that append() and
+  /// operator[](ArrayIndex) are amortized O(1).
+  typedef std::vector<Value, ValueAllocator<Value> > ArrayValues;
+#else
 #ifndef JSON_USE_CPPTL_SMALLMAP
   typedef std::map<CZString, Value> ObjectValues;
 #else
   typedef CppTL::SmallMap<CZString, Value> ObjectValues;
 #endif // ifndef JSON_USE_CPPTL_SMALLMAP
+  /// Elements of an arrayValue, stored contiguously so that append() and
+  /// operator[](ArrayIndex) are amortized O(1).
+  typedef std::vector<Value> ArrayValues;
+#endif // if JSON_USE_VALUE_ARENA
 #endif // ifndef JSON_VALUE_USE_INTERNAL_MAP
 #endif // ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
 
@@ -602,9 +804,28 @@ Json::Value obj_value(Json::objectValue); // {}
 #endif
   Value(bool value);
   Value(const Value& other);
+#if JSON_USE_VALUE_ARENA
+  /// Empty array or object whose storage, member names included, is carved
+  /// from \a arena. Other types ignore the arena.
+  Value(ValueType type, ValueArena& arena);
+  /// String kept in \a arena; the Value never frees it.
+  Value(const char* beginValue, const char* endValue, ValueArena& arena);
+#endif
+#if JSON_HAS_RVALUE_REFERENCES
+  /// Steals the payload, comments and offsets of \a other, leaving it null.
+  /// Lets ArrayValues relocate its elements without deep copies.
+  Value(Value&& other) noexcept;
+#endif
   ~Value();
 
+#if JSON_HAS_RVALUE_REFERENCES
+  Value& operator=(const Value& other);
+  /// Takes over the payload of \a other, which is left null. Like copy
+  /// assignment, it keeps the comments of *this.
+  Value& operator=(Value&& other) noexcept;
+#else
   Value& operator=(Value other);
+#endif
   /// Swap values.
   /// \note Currently, comments are intentionally not swapped, for
   /// both logic and efficiency.
@@ -712,6 +933,10 @@ Json::Value obj_value(Json::objectValue); // {}
   ///
   /// Equivalent to jsonvalue[jsonvalue.size()] = value;
   Value& append(const Value& value);
+#if JSON_HAS_RVALUE_REFERENCES
+  /// Same as append(const Value&), moving \a value into the array.
+  Value& append(Value&& value);
+#endif
 
   /// Access an object value by name, create a null member if it does not exist.
   Value& operator[](const char* key);
@@ -736,6 +961,12 @@ Json::Value obj_value(Json::objectValue); // {}
    * \endcode
    */
   Value& operator[](const StaticString& key);
+  /// Access an object value by a prepared name, create a null member if it
+  /// does not exist. The name is not duplicated.
+  Value& operator[](const StaticKey& key);
+  /// Access an object value by a prepared name, returns null if there is no
+  /// member with that name.
+  const Value& operator[](const StaticKey& key) const;
 #ifdef JSON_USE_CPPTL
   /// Access an object value by name, create a null member if it does not exist.
   Value& operator[](const CppTL::ConstString& key);
@@ -765,6 +996,8 @@ Json::Value obj_value(Json::objectValue); // {}
   bool isMember(const char* key) const;
   /// Return true if the object has a member named key.
   bool isMember(const std::string& key) const;
+  /// Return true if the object has a member named key.
+  bool isMember(const StaticKey& key) const;
 #ifdef JSON_USE_CPPTL
   /// Return true if the object has a member named key.
   bool isMember(const CppTL::ConstString& key) const;
@@ -807,6 +1040,16 @@ Json::Value obj_value(Json::objectValue); // {}
 
 private:
   Value& resolveReference(const char* key, bool isStatic);
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  /// Member \a key, inserted as null when missing; a new name is stored
+  /// according to \a policy. \a interned tells that \a key is the canonical
+  /// copy of the name.
+  Value& resolveReference(const char* key,
+                          CZString::DuplicationPolicy policy,
+                          bool interned);
+  /// Member named \a key, or 0. Requires an objectValue.
+  const Value* findMember(const StaticKey& key) const;
+#endif
 
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   inline bool isItemAvailable() const { return itemIsUsed_ == 0; }
@@ -849,11 +1092,15 @@ private:
     ValueInternalArray* array_;
     ValueInternalMap* map_;
 #else
+    ArrayValues* array_;
     ObjectValues* map_;
 #endif
   } value_;
   ValueType type_ : 8;
   int allocated_ : 1; // Notes: if declared as bool, bitfield is useless.
+  // objectValue: every member name is interned, so a StaticKey that is not
+  // found by address is not a member.
+  unsigned int internedKeys_ : 1;
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   unsigned int itemIsUsed_ : 1; // used by the ValueInternalMap container.
   int memberNameIsStatic_ : 1;  // used by the ValueInternalMap container.
@@ -1281,6 +1528,7 @@ public:
   ValueIteratorBase();
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   explicit ValueIteratorBase(const Value::ObjectValues::iterator& current);
+  ValueIteratorBase(Value::ArrayValues* array, ArrayIndex index);
 #else
   ValueIteratorBase(const ValueInternalArray::IteratorState& state);
   ValueIteratorBase(const ValueInternalMap::IteratorState& state);
@@ -1321,6 +1569,10 @@ protected:
 private:
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   Value::ObjectValues::iterator current_;
+  // Set for arrayValue iterators, which walk the vector by position instead
+  // of current_.
+  Value::ArrayValues* array_;
+  ArrayIndex index_;
   // Indicates that iterator is for a null value.
   bool isNull_;
 #else
@@ -1353,6 +1605,7 @@ private:
  */
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   explicit ValueConstIterator(const Value::ObjectValues::iterator& current);
+  ValueConstIterator(Value::ArrayValues* array, ArrayIndex index);
 #else
   ValueConstIterator(const ValueInternalArray::IteratorState& state);
   ValueConstIterator(const ValueInternalMap::IteratorState& state);
@@ -1409,6 +1662,7 @@ private:
  */
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   explicit ValueIterator(const Value::ObjectValues::iterator& current);
+  ValueIterator(Value::ArrayValues* array, ArrayIndex index);
 #else
   ValueIterator(const ValueInternalArray::IteratorState& state);
   ValueIterator(const ValueInternalMap::IteratorState& state);
@@ -1480,6 +1734,7 @@ public:
 #include <iosfwd>
 #include <stack>
 #include <string>
+#include <vector>
 
 // Disable warning C4251: <data member>: <type> needs to have dll-interface to
 // be used by...
@@ -1561,10 +1816,47 @@ public:
              Value& root,
              bool collectComments = true);
 
+#if JSON_USE_VALUE_ARENA
+  /** \brief Same as above, but every object, array, member name and string
+   * of the document is allocated from \a arena (see ValueArena).
+   */
+  bool parse(const char* beginDoc,
+             const char* endDoc,
+             Value& root,
+             ValueArena& arena,
+             bool collectComments = true);
+#endif
+
   /// \brief Parse from input stream.
   /// \see Json::operator>>(std::istream&, Json::Value&).
   bool parse(std::istream& is, Value& root, bool collectComments = true);
 
+  /** \brief Read a Value from a mutable buffer, in place.
+   *
+   * No copy of the document is made. Escape sequences are decoded inside the
+   * buffer and each string is zero-terminated over its closing quote, so the
+   * string values of \a root point into [beginDoc, endDoc) instead of being
+   * duplicated, as do member names that are not interned (see StaticKey).
+   * The buffer must outlive \a root; copies of \a root own their strings as
+   * usual.
+   *
+   * Error locations are computed on the modified buffer, so a line number
+   * may count newlines decoded from earlier "\n" escapes.
+   */
+  bool parseInSitu(char* beginDoc,
+                   char* endDoc,
+                   Value& root,
+                   bool collectComments = true);
+
+#if JSON_USE_VALUE_ARENA
+  /// parseInSitu() with the objects and arrays carved from \a arena.
+  bool parseInSitu(char* beginDoc,
+                   char* endDoc,
+                   Value& root,
+                   ValueArena& arena,
+                   bool collectComments = true);
+#endif
+
   /** \brief Returns a user friendly string that list errors in the parsed
    * document.
    * \return Formatted error message with the list of errors with their location
@@ -1596,6 +1888,13 @@ public:
    */
   std::vector<StructuredError> getStructuredErrors() const;
 
+  /** \brief Returns whether the last parse completed without error.
+   *
+   * With Features::collectErrors_ off this is the only error report kept,
+   * together with the position given by getStructuredErrors().
+   */
+  bool good() const;
+
 private:
   enum TokenType {
     tokenEndOfStream = 0,
@@ -1646,6 +1945,7 @@ private:
   bool decodeNumber(Token& token, Value& decoded);
   bool decodeString(Token& token);
   bool decodeString(Token& token, std::string& decoded);
+  bool decodeStringInSitu(Token& token, char*& decoded);
   bool decodeDouble(Token& token);
   bool decodeDouble(Token& token, Value& decoded);
   bool decodeUnicodeCodePoint(Token& token,
@@ -1669,10 +1969,12 @@ private:
   std::string getLocationLineAndColumn(Location location) const;
   void addComment(Location begin, Location end, CommentPlacement placement);
   void skipCommentTokens(Token& token);
+  void storeOffsets(Value& value, Location start, Location limit);
 
   typedef std::stack<Value*> Nodes;
   Nodes nodes_;
   Errors errors_;
+  Location errorLocation_; // first error when !features_.collectErrors_
   std::string document_;
   Location begin_;
   Location end_;
@@ -1682,6 +1984,120 @@ private:
   std::string commentsBefore_;
   Features features_;
   bool collectComments_;
+  bool inSitu_;
+#if JSON_USE_VALUE_ARENA
+  ValueArena* arena_;
+#endif
+};
+
+/** \brief Resumable parser for a document that arrives in pieces.
+ *
+ * feed() takes the input a chunk at a time, as it is read from a pipe or a
+ * socket, and grows the Value as the bytes come in, so the tree is complete
+ * when the last byte arrives instead of being built only then. A chunk may
+ * end anywhere, even inside a token.
+ *
+ * The grammar is the one Reader accepts with the same Features, except that
+ * comments are skipped rather than attached to values, and that
+ * allowDroppedNullPlaceholders_ and allowNumericKeys_ are not supported.
+ *
+ * Example of usage:
+ * \code
+ * Json::Value root;
+ * Json::IncrementalReader reader;
+ * reader.reset(root);
+ * while (!reader.done() && !reader.failed() &&
+ *        (n = read(fd, buffer, sizeof(buffer))) > 0)
+ *   rest = reader.feed(buffer, buffer + n);
+ * if (!reader.finish())
+ *   std::cerr << reader.getFormattedErrorMessages();
+ * \endcode
+ */
+class JSON_API IncrementalReader {
+public:
+  IncrementalReader();
+  IncrementalReader(const Features& features);
+
+  /// Starts a new document, read into \a root. \a root is set to null and
+  /// must outlive the parse.
+  void reset(Value& root);
+
+  /** \brief Parses the next chunk of the document.
+   * \return \a endDoc, or the first byte after the document when the
+   * document ends inside the chunk, or the offending byte on error. Bytes
+   * from there on are left to the caller.
+   */
+  const char* feed(const char* beginDoc, const char* endDoc);
+
+  /// Signals the end of the input. A number at the top level is only known
+  /// to be complete at this point.
+  /// \return \c true if a whole document was read.
+  bool finish();
+
+  /// \c true once a whole document has been read.
+  bool done() const;
+
+  /// \c true once a syntax error was found. The document is left partial.
+  bool failed() const;
+
+  /// The error, with its byte offset from the start of the document.
+  std::string getFormattedErrorMessages() const;
+
+private:
+  enum State {
+    expectValue,
+    expectValueOrArrayEnd,
+    expectNameOrObjectEnd,
+    expectName,
+    expectColon,
+    expectSeparator,
+    inString,
+    inEscape,
+    inUnicode,
+    inSurrogateEscape,
+    inSurrogateU,
+    inNumber,
+    inLiteral,
+    inCommentStart,
+    inLineComment,
+    inBlockComment,
+    inBlockCommentEnd,
+    stateDone,
+    stateFailed
+  };
+
+  void readStructural(const char*& current, const char* end);
+  void startValue(const char*& current);
+  void endString(size_t limit);
+  void endNumber(size_t limit);
+  void endUnicode();
+  void closeContainer(size_t limit);
+  void endValue();
+  Value& nextSlot();
+  void fail(const std::string& message, size_t offset);
+  void storeOffsets(Value& value, size_t start, size_t limit);
+  size_t offsetOf(const char* location) const;
+
+  typedef std::vector<Value*> Nodes;
+  Nodes nodes_;
+  Features features_;
+  Value* root_;
+  Value* slot_;
+  State state_;
+  State resume_;
+  bool stringIsName_;
+  std::string token_;
+  std::string name_;
+  const char* literal_;
+  unsigned int matched_;
+  unsigned int unicode_;
+  unsigned int highSurrogate_;
+  int hexDigits_;
+  size_t tokenStart_;
+  size_t offset_;
+  const char* chunk_;
+  std::string error_;
+  size_t errorOffset_;
 };
 
 /** \brief Read from 'sin' into 'root'.
@@ -1,10 +1,22 @@
-#include <iostream>
+#ifndef FAST_STARTUP
+#define FAST_STARTUP 0 // 1：每回合一个进程时压低启动开销，标准输入输出直接用 read/write，不经过 iostream 和 stdio
+#endif
+#if !FAST_STARTUP
+#include <iostream> // 只有用 cin 读入时需要；不包含就没有标准流的静态初始化
+#endif
 #include <set>
 #include <vector>
 #include <string>
 #include <cassert>
+#include <cstdio>
+#include <climits>
 #include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include "jsoncpp/json.h"
 
 using std::set;
@@ -74,7 +86,35 @@ const Level level_JOKER = 14;
 
 Level c2l(Card card) {return card / 4 + card / 53;}
 
-int oppocnt[MAX_LEVEL];
+// 不区分花色的牌：只记每种点数有几张，多留一格凑满 16 格
+struct LevelCount {
+    short c[MAX_LEVEL + 1] = {};
+
+    short &operator [](int l) {return c[l];}
+    short operator [](int l) const {return c[l];}
+
+    LevelCount operator -(const LevelCount &b) const {
+        LevelCount r;
+        for (int l = 0; l <= MAX_LEVEL; ++l) r.c[l] = c[l] - b.c[l];
+        return r;
+    }
+
+    int size() const {
+        int s = 0;
+        for (int l = 0; l <= MAX_LEVEL; ++l) s += c[l];
+        return s;
+    }
+
+    // 每种点数取编号最小的几张作为代表牌
+    vector<Card> cards() const {
+        vector<Card> v;
+        for (Level l = 0; l < level_joker; ++l)
+            for (int k = 0; k < c[l]; ++k) v.push_back(l * 4 + k);
+        if (c[level_joker]) v.push_back(card_joker);
+        if (c[level_JOKER]) v.push_back(card_JOKER);
+        return v;
+    }
+};
 
 struct CardCombo {
     struct CardPack {
@@ -103,6 +143,13 @@ struct CardCombo {
 
     CardCombo() : comboType(CardComboType::PASS) {}
 
+    // 牌型只和每种点数的张数有关，用代表牌构造
+    explicit CardCombo(const LevelCount &lc)
+    {
+        vector<Card> v = lc.cards();
+        *this = CardCombo(v.begin(), v.end());
+    }
+
     template <typename CARD_ITERATOR>
     CardCombo(CARD_ITERATOR begin, CARD_ITERATOR end)
     {
@@ -306,7 +353,8 @@ struct CardCombo {
         return b.comboType == comboType && b.cards.size() == cards.size() && b.comboLevel > comboLevel;
     }
 
-    bool unbe() {
+    // oppocnt：还没出现过的各点数张数
+    bool unbe(const int *oppocnt) {
         int l = findMaxSeq(), c = packs[0].count;
         int tmp = MAX_LEVEL;
         if (comboType == CardComboType::STRAIGHT || comboType == CardComboType::STRAIGHT2 || comboType == CardComboType::PLANE || comboType == CardComboType::PLANE1 || comboType == CardComboType::PLANE2) {
@@ -328,14 +376,27 @@ struct ComboSet {
     double value, cntC; int cntSmall;
     short count[MAX_LEVEL], countOfCount[5];
 
+    // 拆分过程中的临时数组：每个线程一份，清空后复用已经分配好的容量
+    struct Scratch {
+        vector<Card> two, joker, packs[5], sg, pr, tri, qu, run, tmpvec, tstr1[5], str1[5], tstr2[5], str2[5];
+        vector<int> erasor;
+    };
+
+    // 拆分只看点数，按代表牌计算
+    ComboSet(const LevelCount &lc, const int *oppocnt) : ComboSet(lc.cards(), oppocnt) {}
+    ComboSet(const vector<Card> &v, const int *oppocnt) : ComboSet(v.begin(), v.end(), oppocnt) {}
+
     template <typename Card_IT>
-    ComboSet(Card_IT begin, Card_IT end) {
+    ComboSet(Card_IT begin, Card_IT end, const int *oppocnt) {
         cards = vector<Card>(begin, end);
         sort(cards.begin(), cards.end());
         value = -120.0, cntC = 30.0, cntSmall = 0;
         memset(count, 0, sizeof(count));
         memset(countOfCount, 0, sizeof(countOfCount));
-        vector<Card> two, joker, packs[5];
+        static thread_local Scratch s;
+        vector<Card> &two = s.two, &joker = s.joker, *packs = s.packs;
+        two.clear(), joker.clear();
+        for (int i = 0; i < 5; ++i) packs[i].clear();
 
         for (int i = 0; i < cards.size(); ++i) {
             Card c = cards[i]; count[c2l(c)]++;
@@ -349,11 +410,12 @@ struct ComboSet {
         int num[5] = {0};
         for (int i = 0; i < 5; ++i) sort(packs[i].begin(), packs[i].end()), num[i] = packs[i].size();
 
-        int pow3[] = {1, 3, 9, 27, 81, 243, 729}, pow5[] = {1, 5, 25, 125, 625, 3125, 15625};
+        static const int pow3[] = {1, 3, 9, 27, 81, 243, 729}, pow5[] = {1, 5, 25, 125, 625, 3125, 15625};
         for (int q2 = 0; q2 < (1 << (num[2] / 2)); ++q2)
             for (int q3 = 0; q3 < pow3[num[3] / 3]; ++q3)
                 for (int q4 = 0; q4 < pow5[num[4] / 4]; ++q4) {
-                    vector<Card> sg = packs[1], pr, tri, qu;
+                    vector<Card> &sg = s.sg, &pr = s.pr, &tri = s.tri, &qu = s.qu;
+                    sg.assign(packs[1].begin(), packs[1].end()), pr.clear(), tri.clear(), qu.clear();
                     int tmp = q2;
                     for (int r = 0; r < num[2]; r += 2) {
                         if (tmp % 2 == 0) {
@@ -389,11 +451,11 @@ struct ComboSet {
                         tmp /= 5;
                     }
                     sort(sg.begin(), sg.end());
-                    vector<Card> tstr1[5]; int tcntstr1 = 0;
+                    vector<Card> *tstr1 = s.tstr1; int tcntstr1 = 0;
                     for (int i = 0; i < sg.size(); ++i) {
                         if (sg[i] == 80) continue;
-                        vector<Card> tmp; int j = i + 1; tmp.push_back(sg[i]);
-                        vector<int> erasor;
+                        vector<Card> &tmp = s.run; int j = i + 1; tmp.clear(), tmp.push_back(sg[i]);
+                        vector<int> &erasor = s.erasor; erasor.clear();
                         while (j < sg.size() && tmp.size() < 5) {
                             if (sg[j] == 80) {++j; continue;}
                             if (c2l(sg[j]) == c2l(tmp.back())) ++j;
@@ -422,7 +484,7 @@ struct ComboSet {
                             }
                         }
 
-                    vector<Card> str1[5]; int cntstr1 = 0;
+                    vector<Card> *str1 = s.str1; int cntstr1 = 0;
                     for (int i = 0; i < tcntstr1; ++i)
                         if (!tstr1[i].empty()) str1[cntstr1++] = tstr1[i];
 
@@ -430,11 +492,11 @@ struct ComboSet {
                     while (!sg.empty() && sg.back() == 80) sg.pop_back();
 
                     sort(pr.begin(), pr.end());
-                    vector<Card> tstr2[5]; int tcntstr2 = 0;
+                    vector<Card> *tstr2 = s.tstr2; int tcntstr2 = 0;
                     for (int i = 0; i < pr.size(); i += 2) {
                         if (pr[i] == 80) continue;
-                        vector<Card> tmp; int j = i + 2; tmp.push_back(pr[i]), tmp.push_back(pr[i + 1]);
-                        vector<int> erasor;
+                        vector<Card> &tmp = s.run; int j = i + 2; tmp.clear(), tmp.push_back(pr[i]), tmp.push_back(pr[i + 1]);
+                        vector<int> &erasor = s.erasor; erasor.clear();
                         while (j < pr.size() && tmp.size() < 6) {
                             if (pr[j] == 80) {j += 2; continue;}
                             if (c2l(pr[j]) == c2l(tmp.back())) j += 2;
@@ -469,7 +531,7 @@ struct ComboSet {
                             }
                         }
 
-                    vector<Card> str2[5]; int cntstr2 = 0;
+                    vector<Card> *str2 = s.str2; int cntstr2 = 0;
                     for (int i = 0; i < tcntstr2; ++i)
                         if (!tstr2[i].empty()) str2[cntstr2++] = tstr2[i];
 
@@ -477,17 +539,17 @@ struct ComboSet {
                     while (!pr.empty() && pr.back() == 80) pr.pop_back();
 
                     double tmpval = 0, tmpC = 0; int tmpCint = 0, tmpSmall = 0;
-                    vector<Card> tmpvec;
+                    vector<Card> &tmpvec = s.tmpvec; tmpvec.clear();
 
                     for (int i = 0; i < sg.size(); ++i) {
                         tmpvec.push_back(c2l(sg[i]));
                         Card c[] = {sg[i]};
-                        if (!CardCombo(c, c + 1).unbe()) ++tmpSmall;
+                        if (!CardCombo(c, c + 1).unbe(oppocnt)) ++tmpSmall;
                     }
                     for (int i = 0; i < pr.size(); i += 2) {
                         tmpvec.push_back(c2l(pr[i]));
                         Card c[] = {pr[i], pr[i + 1]};
-                        if (!CardCombo(c, c + 2).unbe()) ++tmpSmall;
+                        if (!CardCombo(c, c + 2).unbe(oppocnt)) ++tmpSmall;
                     }
                     sort(tmpvec.begin(), tmpvec.end());
 
@@ -538,19 +600,19 @@ struct ComboSet {
                         }
                         for (int i = 0; i < tri.size(); i += 3) {
                             Card c[] = {tri[i], tri[i + 1], tri[i + 2]};
-                            if (!CardCombo(c, c + 3).unbe()) ++tmpSmall;
+                            if (!CardCombo(c, c + 3).unbe(oppocnt)) ++tmpSmall;
                         }
                         for (int i = 0; i < qu.size(); i += 4) {
                             Card c[] = {qu[i], qu[i + 1], qu[i + 2], qu[i + 3]};
-                            if (!CardCombo(c, c + 4).unbe()) ++tmpSmall;
+                            if (!CardCombo(c, c + 4).unbe(oppocnt)) ++tmpSmall;
                         }
                         for (int i = 0; i < cntstr1; ++i)
-                            if (!CardCombo(str1[i].begin(), str1[i].end()).unbe()) ++tmpSmall;
+                            if (!CardCombo(str1[i].begin(), str1[i].end()).unbe(oppocnt)) ++tmpSmall;
                         for (int i = 0; i < cntstr2; ++i)
-                            if (!CardCombo(str2[i].begin(), str2[i].end()).unbe()) ++tmpSmall;
+                            if (!CardCombo(str2[i].begin(), str2[i].end()).unbe(oppocnt)) ++tmpSmall;
 
                         if (!joker.empty()) {
-                            if (!CardCombo(joker.begin(), joker.end()).unbe()) ++tmpSmall;
+                            if (!CardCombo(joker.begin(), joker.end()).unbe(oppocnt)) ++tmpSmall;
                         }
 
                         cntSmall = tmpSmall, cntC = tmpC, value = tmpval;
@@ -559,23 +621,113 @@ struct ComboSet {
     }
 };
 
-CardCombo lastValidCombo;
-
 struct History {
     Stage stage;
     vector<Card> pub; int llPos, f1Pos, f2Pos;
     vector<CardCombo> playedCombos[3];
     vector<int> bids;
     int numOfCards[3];
-    History() {numOfCards[0] = 17, numOfCards[1] = 17, numOfCards[2] = 17; stage = Stage::BIDDING;}
-} hist;
+    History() {numOfCards[0] = 17, numOfCards[1] = 17, numOfCards[2] = 17; stage = Stage::BIDDING; llPos = f1Pos = f2Pos = 0;}
+};
+
+// 候选估值的线程数，0 表示取 CPU 核数，1 表示不开线程
+// 每回合一个进程时起线程的开销比省下的估值时间还多，所以只有长时运行默认开线程
+#ifndef EVAL_THREADS
+#if defined(KEEP_RUNNING) && KEEP_RUNNING
+#define EVAL_THREADS 0
+#else
+#define EVAL_THREADS 1
+#endif
+#endif
+
+// 固定大小的线程池：parallelFor 把 [0, n) 的下标分给各线程（调用线程也参与），
+// 每一轮所有线程都报到一次之后才返回，所以不会有线程拿着上一轮的任务
+struct ThreadPool {
+    vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable wake, finished;
+    std::function<void(unsigned)> job;
+    std::atomic<unsigned> next{0};
+    unsigned total = 0, idle = 0, round = 0;
+    bool stopping = false;
+
+    explicit ThreadPool(unsigned n) {
+        for (unsigned i = 1; i < n; ++i) workers.emplace_back([this] {work();});
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &t : workers) t.join();
+    }
+
+    unsigned size() const {return workers.size() + 1;}
+
+    void work() {
+        unsigned seen = 0;
+        std::unique_lock<std::mutex> lock(mtx);
+        for (;;) {
+            wake.wait(lock, [&] {return stopping || round != seen;});
+            if (stopping) return;
+            seen = round;
+            lock.unlock();
+            run();
+            lock.lock();
+            if (++idle == workers.size()) finished.notify_one();
+        }
+    }
+
+    void run() {
+        for (unsigned i; (i = next++) < total; ) job(i);
+    }
+
+    void parallelFor(unsigned n, const std::function<void(unsigned)> &f) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            job = f, total = n, idle = 0, next = 0, ++round;
+        }
+        wake.notify_all();
+        run();
+        std::unique_lock<std::mutex> lock(mtx);
+        finished.wait(lock, [&] {return idle == workers.size();});
+    }
+};
+
+#ifndef CANDIDATE_TOPK
+#define CANDIDATE_TOPK 0 // 完整估值的候选数上限，0 表示不剪枝（默认）；剪枝会改变少数局面的出牌，开之前先用本地裁判比较强度
+#endif
+
+// 候选出牌：先用静态估值排序，只有前 topK 个才拆分剩余手牌做完整估值
+struct Candidate {
+    CardCombo combo;            // 由代表牌组成
+    LevelCount rem;             // 出牌后剩余的牌
+    double bonus, cntAdj;       // 与剩余牌拆分无关的估值修正、手数修正
+    double quick;               // 静态估值
+    bool kept = true;           // 是否进入完整估值
+    double val, cntC;           // 完整估值的结果
+
+    Candidate(const CardCombo &combo, const LevelCount &rem, double bonus, double cntAdj) :
+        combo(combo), rem(rem), bonus(bonus), cntAdj(cntAdj) {
+        // 静态估值：剩余牌种数近似手数，另外惩罚 2 以下的散单
+        int singles = 0, kinds = 0;
+        for (int i = 0; i < MAX_LEVEL; ++i) {
+            if (rem[i]) ++kinds;
+            if (rem[i] == 1 && i < 12) ++singles;
+        }
+        quick = bonus - 5.0 * kinds - 2.0 * singles;
+    }
+};
+
+struct GameContext;
 
 struct Player {
     vector<Card> myCards;
-    int myPos;
-    int cnt[MAX_LEVEL + 1], cntlev;
+    int myPos = 0;
+    LevelCount cnt; int cntlev = 0;
 
-    Player() {memset(cnt, 0, sizeof cnt);}
     void gain(Card c) {myCards.push_back(c); ++cnt[c2l(c)];}
 
     template <typename T>
@@ -587,272 +739,74 @@ struct Player {
         while (!myCards.empty() && myCards.back() == 80) myCards.pop_back();
     }
 
-    int minopnum() {
-        if (myPos == hist.llPos)
-            return (hist.numOfCards[hist.f1Pos] < hist.numOfCards[hist.f2Pos] ? hist.numOfCards[hist.f1Pos] : hist.numOfCards[hist.f2Pos]);
-        return hist.numOfCards[hist.llPos];
-    }
-
-    CardCombo action(const CardCombo &lt, int stat) {
-//        std::cout << hist.llPos << ' ' << hist.numOfCards[hist.llPos] << '\n';
-        CardComboType ltType = lt.comboType;
-        if (ltType == CardComboType::PASS) {
-            if (CardCombo(myCards.begin(), myCards.end()).comboType != CardComboType::INVALID) return CardCombo(myCards.begin(), myCards.end());
-            ComboSet origin = ComboSet(myCards.begin(), myCards.end());
-            double opval = -120.0, opcntC = 30.0; CardCombo optim;
-            unsigned par1[] = {1, 2, 3, 4, 4, 5, 5, 6, 7, 8, 9, 10, 11, 12, 6, 8, 10, 12, 14, 16, 18, 20, 6, 9, 12, 15, 18, 8, 10, 12, 15, 16, 20, 20, 12, 18, 16, 8, 12, 16, 6, 8};
-            int par2[] = {1, 1, 1, 1, 1, 1, 5, 6, 7, 8, 9, 10, 11, 12, 3, 4, 5, 6, 7, 8, 9, 10, 2, 3, 4, 5, 6, 2, 2, 3, 3, 4, 4, 5, 2, 3, 2, 2, 3, 4, 1, 1};
-            int par3[] = {1, 2, 3, 4, 3, 3, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
-            int par4[] = {0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 3, 3, 4, 4, 5, 4, 6, 4, 0, 0, 0 ,2, 2};
-            int par5[] = {0, 0, 0, 0, 1, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 1, 2, 1, 2, 1, 1, 1, 2, 0, 0, 0, 1, 2};
-            CardComboType par6[] = {
-                CardComboType::SINGLE, CardComboType::PAIR, CardComboType::TRIPLET, CardComboType::BOMB, CardComboType::TRIPLET1, CardComboType::TRIPLET2,
-                CardComboType::STRAIGHT, CardComboType::STRAIGHT, CardComboType::STRAIGHT, CardComboType::STRAIGHT, CardComboType::STRAIGHT, CardComboType::STRAIGHT, CardComboType::STRAIGHT, CardComboType::STRAIGHT,
-                CardComboType::STRAIGHT2, CardComboType::STRAIGHT2, CardComboType::STRAIGHT2, CardComboType::STRAIGHT2, CardComboType::STRAIGHT2, CardComboType::STRAIGHT2, CardComboType::STRAIGHT2, CardComboType::STRAIGHT2,
-                CardComboType::PLANE, CardComboType::PLANE, CardComboType::PLANE, CardComboType::PLANE, CardComboType::PLANE, CardComboType::PLANE1, CardComboType::PLANE2, CardComboType::PLANE1, CardComboType::PLANE2, CardComboType::PLANE1, CardComboType::PLANE2, CardComboType::PLANE1,
-                CardComboType::SSHUTTLE2, CardComboType::SSHUTTLE2, CardComboType::SSHUTTLE4, CardComboType::SSHUTTLE, CardComboType::SSHUTTLE, CardComboType::SSHUTTLE, CardComboType::QUADRUPLE2, CardComboType::QUADRUPLE4
-            };
-
-            cntlev = 0; for (int i = 0; i < MAX_LEVEL; ++i) if (cnt[i]) ++cntlev;
-            for (int ind = 0; ind < 42; ++ind) {
-                if (myCards.size() < par1[ind]) continue;
-                if (cntlev < par2[ind] + par4[ind]) continue;
-                bool maxIsStr =
-                    par6[ind] == CardComboType::STRAIGHT || par6[ind] == CardComboType::STRAIGHT2 ||
-                    par6[ind] == CardComboType::PLANE || par6[ind] == CardComboType::PLANE1 || par6[ind] == CardComboType::PLANE2 ||
-                    par6[ind] == CardComboType::SSHUTTLE || par6[ind] == CardComboType::SSHUTTLE2 || par6[ind] == CardComboType::SSHUTTLE4;
-                int cntmain = par2[ind];
-                for (Level lvl = 0; ; ++lvl) {
-                    int flag = 0;
-                    for (int j = 0; j < cntmain; ++j) {
-                        int lev = lvl + cntmain - 1 - j;
-                        if (
-                            (par6[ind] == CardComboType::SINGLE && lev >= MAX_LEVEL) ||
-                            (par6[ind] != CardComboType::SINGLE && !maxIsStr && lev >= level_joker) ||
-                            (maxIsStr && lev >= MAX_STRAIGHT_LEVEL)
-                        ) {flag = 2; break;}
-                        if (cnt[lev] < par3[ind]) {flag = 1; break;}
-                    }
-                    if (flag == 1) continue;
-                    else if (flag == 2) break;
-                    vector<Card> aux, chos, rem;
-                    int reqcnt[MAX_LEVEL + 1] = {0}, auxcnt = par4[ind];
-                    for (int j = 0; j < cntmain; ++j) reqcnt[cntmain - j + lvl - 1] = par3[ind];
-                    if (auxcnt == 0) {
-                        for (int i = 0; i < myCards.size(); ++i) {
-                            if (reqcnt[c2l(myCards[i])]) chos.push_back(myCards[i]), --reqcnt[c2l(myCards[i])];
-                            else rem.push_back(myCards[i]);
-                        }
-                        CardCombo chCombo = CardCombo(chos.begin(), chos.end());
-                        if (chCombo.comboType == CardComboType::INVALID) continue;
-                        ComboSet remSet = ComboSet(rem.begin(), rem.end());
-                        double tmpval = remSet.value, tmpcntC = remSet.cntC;
-
-                        if (chCombo.unbe() && (remSet.cntSmall <= 1 || CardCombo(rem.begin(), rem.end()).comboType != CardComboType::INVALID)) tmpval += 150.0;
-                        if (stat == 2 && hist.numOfCards[hist.f2Pos] == 1 && chos.size() == 1 && c2l(chos.back()) <= 3) tmpval += 100.0;
-                        tmpcntC -= (double)chos.size() * 0.15;
-                        if (stat == 0 && chos.size() <= 3 && (chos.size() == hist.numOfCards[hist.f1Pos] || chos.size() == hist.numOfCards[hist.f2Pos])) {
-                            tmpval -= 100.0; if (chos.size() == 1 || chos.size() == 2) tmpval += (double)c2l(chos.back()) * 2.0;
-                        }
-                        if ((stat == 2 || stat == 3) && chos.size() <= 3 && chos.size() == hist.numOfCards[hist.llPos]) {
-//                            std::cout << chos.size() << ' ' << c2l(chos.front()) + 3 << ' ' << tmpval << '\n';
-                            tmpval -= 100.0; if (chos.size() == 1 || chos.size() == 2) tmpval += (double)c2l(chos.back()) * 2.0;
-                        }
-                        if ((opval - opcntC * 5.0) < (tmpval - tmpcntC * 5.0)) opval = tmpval, opcntC = tmpcntC, optim = chCombo;
-                    } else if (auxcnt > 0) {
-                        for (int k = 0; k < MAX_LEVEL; ++k) {
-                            if (reqcnt[k] || cnt[k] < par5[ind]) continue;
-                            aux.push_back(k);
-                        }
-                        if (aux.size() < auxcnt) continue;
-                        vector<int> use;
-                        for (int i = 0; i < auxcnt; ++i) use.push_back(1);
-                        for (int i = 0; i < aux.size() - auxcnt; ++i) use.push_back(0);
-                        do {
-                            chos.clear(); rem.clear(); memset(reqcnt, 0, sizeof reqcnt);
-                            for (int j = 0; j < cntmain; ++j) reqcnt[cntmain - j + lvl - 1] = par3[ind];
-                            bool flag = false;
-                            for (int i = 0; i < aux.size(); ++i) {
-                                reqcnt[aux[i]] = par5[ind] * use[i];
-                                if (reqcnt[aux[i]] > cnt[aux[i]]) flag = true;
-                            }
-                            if (flag) continue;
+    unsigned topK = CANDIDATE_TOPK;
 
-                            for (int i = 0; i < myCards.size(); ++i) {
-                                if (reqcnt[c2l(myCards[i])] > 0) chos.push_back(myCards[i]), --reqcnt[c2l(myCards[i])];
-                                else rem.push_back(myCards[i]);
-                            }
-                            CardCombo chCombo = CardCombo(chos.begin(), chos.end());
-                            if (chCombo.comboType == CardComboType::INVALID) continue;
-                            ComboSet remSet = ComboSet(rem.begin(), rem.end());
-                            double tmpval = remSet.value, tmpcntC = remSet.cntC;
-
-                            if (chCombo.unbe() && (remSet.cntSmall <= 1 || CardCombo(rem.begin(), rem.end()).comboType != CardComboType::INVALID)) tmpval += 150.0;
-                            tmpcntC -= (double)chos.size() * 0.15;
-                            if (stat == 0 && chos.size() <= 3 && (chos.size() == hist.numOfCards[hist.f1Pos] || chos.size() == hist.numOfCards[hist.f2Pos])) {
-                                tmpval -= 100.0; if (chos.size() == 1 || chos.size() == 2) tmpval += (double)c2l(chos.back()) * 2.0;
-                            }
-                            if ((stat == 2 || stat == 3) && chos.size() <= 3 && chos.size() == hist.numOfCards[hist.llPos]) {
-                                tmpval -= 100.0; if (chos.size() == 1 || chos.size() == 2) tmpval += (double)c2l(chos.back()) * 2.0;
-                            }
-                            if ((opval - opcntC * 5.0) < (tmpval - tmpcntC * 5.0)) opval = tmpval, opcntC = tmpcntC, optim = chCombo;
-                        } while (next_permutation(use.begin(), use.end()));
-                    }
-                }
-            }
-            for (Level i = 0; i < level_joker; ++i) {
-                if (cnt[i] == 4) {
-                    Card bomb[] = {Card(i * 4), Card(i * 4 + 1), Card(i * 4 + 2), Card(i * 4 + 3)};
-                    vector<Card> rem;
-                    for (int j = 0; j < myCards.size(); ++j)
-                        if (myCards[j] / 4 != i) rem.push_back(myCards[j]);
-
-                    vector<Level> oppobomb;
-                    for (Level j = 0; j < level_joker; ++j)
-                        if (oppocnt[j] == 4) oppobomb.push_back(j);
-                    bool mayDie = false;
-                    for (int k = 0; k < oppobomb.size(); ++k) if (oppobomb[k] > i) mayDie = true;
-
-                    if (rem.empty() || (CardCombo(rem.begin(), rem.end()).comboType != CardComboType::INVALID && !mayDie))
-                        return CardCombo(bomb, bomb + 4);
-                }
-            }
-            if (cnt[level_joker] + cnt[level_JOKER] == 2) {
-                Card rocket[] = {card_joker, card_JOKER};
-                vector<Card> rem;
-                for (int i = 0; i < myCards.size(); ++i) if (myCards[i] < card_joker) rem.push_back(myCards[i]);
-
-                if (rem.empty() || (CardCombo(rem.begin(), rem.end()).comboType != CardComboType::INVALID))
-                    return CardCombo(rocket, rocket + 2);
-            }
-            return optim;
-        } else {
-            ComboSet origin = ComboSet(myCards.begin(), myCards.end());
-            double opval = origin.value - 7.0, opcntC = origin.cntC; CardCombo optim = CardCombo();
-//            std::cout << opval << ' ' << opcntC << '\n';
-            cntlev = 0; for (int i = 0; i < MAX_LEVEL; ++i) if (cnt[i]) ++cntlev;
-            if ((stat == 1 || stat == 4 || stat == 8 || stat == 5 || stat == 7 || stat == 6) && (minopnum() <= 2))
-                opval -= 22.0;
-            if (ltType == CardComboType::ROCKET) return optim;
-            if (myCards.size() >= lt.cards.size() && cntlev >= lt.packs.size()) {
-                int cntmain = lt.findMaxSeq();
-                bool maxIsStr =
-                    ltType == CardComboType::STRAIGHT || ltType == CardComboType::STRAIGHT2 ||
-                    ltType == CardComboType::PLANE || ltType == CardComboType::PLANE1 || ltType == CardComboType::PLANE2 ||
-                    ltType == CardComboType::SSHUTTLE || ltType == CardComboType::SSHUTTLE2 || ltType == CardComboType::SSHUTTLE4;
-                for (Level lvl = 1; ; ++lvl) {
-                    int flag = 0;
-                    for (int j = 0; j < cntmain; ++j) {
-                        int lev = lt.packs[j].level + lvl;
-                        if (
-                            (ltType == CardComboType::SINGLE && lev >= MAX_LEVEL) ||
-                            (ltType != CardComboType::SINGLE && !maxIsStr && lev >= level_joker) ||
-                            (maxIsStr && lev >= MAX_STRAIGHT_LEVEL)
-                        ) {flag = 2; break;}
-                        if (cnt[lev] < lt.packs[j].count) {flag = 1; break;}
-                    }
-                    if (flag == 1) continue;
-                    else if (flag == 2) break;
-                    vector<Card> aux, chos, rem;
-                    int reqcnt[MAX_LEVEL + 1] = {0}, auxcnt = lt.packs.size() - cntmain;
-                    for (int j = 0; j < cntmain; ++j) reqcnt[lt.packs[j].level + lvl] = lt.packs[j].count;
-
-                    if (auxcnt == 0) {
-                        for (int i = 0; i < myCards.size(); ++i) {
-                            if (reqcnt[c2l(myCards[i])]) chos.push_back(myCards[i]), --reqcnt[c2l(myCards[i])];
-                            else rem.push_back(myCards[i]);
-                        }
-                        CardCombo chCombo = CardCombo(chos.begin(), chos.end());
-                        if (chCombo.comboType == CardComboType::INVALID) continue;
-                        if (rem.empty()) return chCombo;
-
-                        ComboSet remSet = ComboSet(rem.begin(), rem.end());
-                        double tmpval = remSet.value, tmpcntC = remSet.cntC;
-
-                        if (chCombo.unbe() && (remSet.cntSmall <= 1 || CardCombo(rem.begin(), rem.end()).comboType != CardComboType::INVALID)) tmpval += 150.0;
-                        if (stat == 6 || stat == 7 || stat == 8)
-                            if (chos.size() == hist.numOfCards[hist.llPos])
-                                tmpval += ((double)c2l(chos.back()) - 11.0);
-                        if (stat == 5 || stat == 6 || stat == 7)
-                            tmpval -= (double)(lt.comboLevel + chCombo.comboLevel - 11);
-                        if ((opval - opcntC * 5.0) < (tmpval - tmpcntC * 5.0)) opval = tmpval, opcntC = tmpcntC, optim = chCombo; //std::cout << "here\n";
-                    } else if (auxcnt > 0) {
-                        for (int k = 0; k < MAX_LEVEL; ++k) {
-                            if (reqcnt[k] || cnt[k] < lt.packs[cntmain].count) continue;
-                            aux.push_back(k);
-                        }
-                        if (aux.size() < auxcnt) continue;
-                        vector<int> use;
-                        for (int i = 0; i < auxcnt; ++i) use.push_back(1);
-                        for (int i = 0; i < aux.size() - auxcnt; ++i) use.push_back(0);
-                        do {
-                            chos.clear(); rem.clear(); memset(reqcnt, 0, sizeof reqcnt);
-                            for (int j = 0; j < cntmain; ++j) reqcnt[lt.packs[j].level + lvl] = lt.packs[j].count;
-                            for (int i = 0; i < aux.size(); ++i) reqcnt[aux[i]] = lt.packs[cntmain].count * use[i];
-
-                            for (int i = 0; i < myCards.size(); ++i) {
-                                if (reqcnt[c2l(myCards[i])]) chos.push_back(myCards[i]), --reqcnt[c2l(myCards[i])];
-                                else rem.push_back(myCards[i]);
-                            }
-                            CardCombo chCombo = CardCombo(chos.begin(), chos.end());
-                            if (chCombo.comboType == CardComboType::INVALID) continue;
-                            if (rem.empty()) return chCombo;
-
-                            ComboSet remSet = ComboSet(rem.begin(), rem.end());
-                            double tmpval = remSet.value, tmpcntC = remSet.cntC;
+    // 按每种点数需要的张数从手牌里取出具体的牌，保持手牌原有顺序
+    vector<Card> pick(LevelCount need) const {
+        vector<Card> chos;
+        for (unsigned i = 0; i < myCards.size(); ++i)
+            if (need[c2l(myCards[i])] > 0) chos.push_back(myCards[i]), --need[c2l(myCards[i])];
+        return chos;
+    }
 
-                            if (chCombo.unbe() && (remSet.cntSmall <= 1 || CardCombo(rem.begin(), rem.end()).comboType != CardComboType::INVALID)) tmpval += 150.0;
-                            if (stat == 5 || stat == 6 || stat == 7) tmpval -= (double)(lt.comboLevel + chCombo.comboLevel - 11);
-                            if (stat == 6 || stat == 7 || stat == 8)
-                                if (chos.size() == hist.numOfCards[hist.llPos])
-                                    tmpval += ((double)c2l(chos.back()) - 11.0);
-                            if ((opval - opcntC * 5.0) < (tmpval - tmpcntC * 5.0)) opval = tmpval, opcntC = tmpcntC, optim = chCombo;
-                        } while (next_permutation(use.begin(), use.end()));
-                    }
-                }
+    // 从 aux 的牌种中选 k 种、每种 per 张作为带牌，每种组合恰好枚举一次
+    // 用 Gosper's hack 按位枚举 k 元子集，need 和剩余手牌 rem 都只更新和上一个组合相比变化的牌种
+    // emit(need, rem) 返回 true 时停止枚举
+    template <typename F>
+    void enumKickers(const vector<Level> &aux, int k, int per, LevelCount &need, F emit) const {
+        unsigned n = aux.size(), last = 0;
+        LevelCount rem = cnt - need;
+        for (unsigned m = (1u << k) - 1; m < (1u << n); ) {
+            for (unsigned d = m ^ last; d; d &= d - 1) {
+                int i = __builtin_ctz(d);
+                if (m >> i & 1) need[aux[i]] = per, rem[aux[i]] -= per;
+                else need[aux[i]] = 0, rem[aux[i]] += per;
             }
-            for (Level i = 0; i < level_joker; ++i) {
-                if (cnt[i] == 4 && (ltType != CardComboType::BOMB || i > lt.packs[0].level)) {
-                    Card bomb[] = {Card(i * 4), Card(i * 4 + 1), Card(i * 4 + 2), Card(i * 4 + 3)};
-                    vector<Card> rem;
-                    for (int j = 0; j < myCards.size(); ++j)
-                        if (myCards[j] / 4 != i) rem.push_back(myCards[j]);
-                    if (rem.empty() || CardCombo(rem.begin(), rem.end()).comboType != CardComboType::INVALID)
-                        return CardCombo(bomb, bomb + 4);
-
-                    ComboSet remSet = ComboSet(rem.begin(), rem.end());
-                    double tmpval = remSet.value, tmpcntC = remSet.cntC;
+            last = m;
+            if (emit(need, rem)) return;
+            unsigned low = m & -m, r = m + low;
+            m = (((r ^ m) >> 2) / low) | r;
+        }
+    }
 
-                    if (stat == 6 || stat == 7 || stat == 8)
-                        if (hist.numOfCards[hist.llPos] == lt.cards.size()) tmpval += 12.0;
-                    if (stat == 5 || stat == 6 || stat == 7)
-                        tmpval -= 20.0;
-                    if ((opval - opcntC * 5.0) < (tmpval - tmpcntC * 5.0)) opval = tmpval, opcntC = tmpcntC, optim = CardCombo(bomb, bomb + 4);
-                }
-            }
-            if (cnt[level_joker] + cnt[level_JOKER] == 2) {
-                Card rocket[] = {card_joker, card_JOKER};
-                vector<Card> rem;
-                for (int j = 0; j < myCards.size(); ++j)
-                    if (myCards[j] < card_joker) rem.push_back(myCards[j]);
-                if (rem.empty() || CardCombo(rem.begin(), rem.end()).comboType != CardComboType::INVALID)
-                    return CardCombo(rocket, rocket + 2);
+    // 按静态估值保留前 topK 个候选，其余不做完整估值
+    void prune(vector<Candidate> &cands) {
+        if (topK == 0 || cands.size() <= topK) return;
+        vector<unsigned> ord(cands.size());
+        for (unsigned i = 0; i < ord.size(); ++i) ord[i] = i, cands[i].kept = false;
+        std::stable_sort(ord.begin(), ord.end(), [&](unsigned a, unsigned b) {return cands[a].quick > cands[b].quick;});
+        for (unsigned i = 0; i < topK; ++i) cands[ord[i]].kept = true;
+    }
 
-                ComboSet remSet = ComboSet(rem.begin(), rem.end());
-                double tmpval = remSet.value, tmpcntC = remSet.cntC;
-                if (stat == 1 && (hist.numOfCards[hist.f1Pos] <= 2 || hist.numOfCards[hist.f2Pos] <= 2)) tmpval += 100.0;
-                if (stat == 6 || stat == 7 || stat == 8)
-                    if (hist.numOfCards[hist.llPos] == lt.cards.size()) tmpval += 15.0;
-                if (stat == 5 || stat == 6 || stat == 7)
-                    tmpval -= 25.0;
-                if ((opval - opcntC * 5.0) < (tmpval - tmpcntC * 5.0)) opval = tmpval, opcntC = tmpcntC, optim = CardCombo(rocket, rocket + 2);
-            }
-            return optim;
-        }
+    // 完整估值：拆分剩余手牌；只读局面、只写自己的候选，可以在多个线程里同时做
+    static void evaluate(Candidate &cd, const int *oppocnt) {
+        ComboSet remSet = ComboSet(cd.rem, oppocnt);
+        cd.val = remSet.value, cd.cntC = remSet.cntC + cd.cntAdj;
+        if (cd.combo.unbe(oppocnt) && (remSet.cntSmall <= 1 || CardCombo(cd.rem).comboType != CardComboType::INVALID)) cd.val += 150.0;
+        cd.val += cd.bonus;
     }
-} player;
 
-void cntoppo() {
+    void pickBest(const GameContext &g, vector<Candidate> &cands, double &opval, double &opcntC, CardCombo &optim);
+    int minopnum(const GameContext &g) const;
+    CardCombo action(const GameContext &g, const CardCombo &lt, int stat);
+    CardCombo search(const GameContext &g, const CardCombo &lt, int stat);
+};
+
+// 一局游戏的全部状态。各函数都显式地拿到它，同一进程里的多个局面（多线程、多局）互不干扰
+struct GameContext {
+    History hist;
+    Player player;
+    int oppocnt[MAX_LEVEL];     // 还没出现过的各点数张数（不含自己的手牌）
+    CardCombo lastValidCombo;   // 当前要压的牌
+    vector<Card> lastResponse;  // 上一回合自己的出牌，长时运行时在下一回合开头补进历史
+    bool lastWasPlay = false;
+    ThreadPool *pool = nullptr; // 候选估值用的线程池（至少两个线程），由持有局面的一方提供；空表示在调用线程里直接估值
+
+    GameContext() {memset(oppocnt, 0, sizeof(oppocnt));}
+};
+
+void cntoppo(GameContext &g) {
+    const History &hist = g.hist; const Player &player = g.player; int *oppocnt = g.oppocnt;
     for (int i = 0; i < level_joker; ++i) oppocnt[i] = 4;
     oppocnt[level_JOKER] = 1;
     oppocnt[level_joker] = 1;
@@ -866,7 +820,8 @@ void cntoppo() {
     }
 }
 
-int status() {
+int status(const GameContext &g) {
+    const History &hist = g.hist; const Player &player = g.player;
     if (player.myPos == hist.llPos) {
         if (
             hist.playedCombos[hist.f1Pos].back().comboType == CardComboType::PASS &&
@@ -900,123 +855,1770 @@ int status() {
     return -1;
 }
 
-namespace BotzoneIO {
-    using namespace std;
-    void read() {
-        string line;
-        getline(cin, line);
-        Json::Value input;
-        Json::Reader reader;
-        reader.parse(line, input);
-        {
-            auto firstRequest = input["requests"][0u];
-            auto own = firstRequest["own"];
-            for (unsigned i = 0; i < own.size(); i++)
-                player.gain(own[i].asInt());
-            if (!firstRequest["bid"].isNull()) {
-                auto bidHistory = firstRequest["bid"];
-                player.myPos = bidHistory.size();
-                for (unsigned i = 0; i < bidHistory.size(); i++)
-                    hist.bids.push_back(bidHistory[i].asInt());
-            }
-        }
-
-        int turn = input["requests"].size();
-        for (int i = 0; i < turn; ++i) {
-            auto request = input["requests"][i];
-            auto llpublic = request["publiccard"];
-            if (!llpublic.isNull()) {
-                hist.llPos = request["landlord"].asInt();
-//                landlordBid = request["finalbid"].asInt();
-                player.myPos = request["pos"].asInt();
-                hist.numOfCards[hist.llPos] += llpublic.size();
-                for (unsigned i = 0; i < llpublic.size(); i++) {
-                    hist.pub.push_back(llpublic[i].asInt());
-                    if (hist.llPos == player.myPos)
-                        player.gain(llpublic[i].asInt());
+// 剪枝后把完整估值分给线程池，再按生成顺序比较，所以选出的牌和单线程时一样
+void Player::pickBest(const GameContext &g, vector<Candidate> &cands, double &opval, double &opcntC, CardCombo &optim) {
+    prune(cands);
+    vector<unsigned> ids;
+    for (unsigned i = 0; i < cands.size(); ++i) if (cands[i].kept) ids.push_back(i);
+    if (g.pool && ids.size() > 1)
+        g.pool->parallelFor(ids.size(), [&](unsigned i) {evaluate(cands[ids[i]], g.oppocnt);});
+    else
+        for (unsigned i : ids) evaluate(cands[i], g.oppocnt);
+    for (unsigned i : ids)
+        if ((opval - opcntC * 5.0) < (cands[i].val - cands[i].cntC * 5.0)) opval = cands[i].val, opcntC = cands[i].cntC, optim = cands[i].combo;
+}
+
+int Player::minopnum(const GameContext &g) const {
+    const History &hist = g.hist;
+    if (myPos == hist.llPos)
+        return (hist.numOfCards[hist.f1Pos] < hist.numOfCards[hist.f2Pos] ? hist.numOfCards[hist.f1Pos] : hist.numOfCards[hist.f2Pos]);
+    return hist.numOfCards[hist.llPos];
+}
+
+// 搜索只在点数计数上进行，选定之后才换成手里具体的牌
+CardCombo Player::action(const GameContext &g, const CardCombo &lt, int stat) {
+    CardCombo res = search(g, lt, stat);
+    if (res.comboType == CardComboType::PASS) return res;
+    LevelCount need;
+    for (unsigned i = 0; i < res.packs.size(); ++i) need[res.packs[i].level] = res.packs[i].count;
+    vector<Card> chos = pick(need);
+    return CardCombo(chos.begin(), chos.end());
+}
+
+CardCombo Player::search(const GameContext &g, const CardCombo &lt, int stat) {
+    const History &hist = g.hist;
+    const int *oppocnt = g.oppocnt;
+//    std::cout << hist.llPos << ' ' << hist.numOfCards[hist.llPos] << '\n';
+    CardComboType ltType = lt.comboType;
+    unsigned total = cnt.size();
+    if (ltType == CardComboType::PASS) {
+        if (CardCombo(cnt).comboType != CardComboType::INVALID) return CardCombo(cnt);
+        double opval = -120.0, opcntC = 30.0; CardCombo optim;
+        vector<Candidate> cands;
+        static const unsigned par1[] = {1, 2, 3, 4, 4, 5, 5, 6, 7, 8, 9, 10, 11, 12, 6, 8, 10, 12, 14, 16, 18, 20, 6, 9, 12, 15, 18, 8, 10, 12, 15, 16, 20, 20, 12, 18, 16, 8, 12, 16, 6, 8};
+        static const int par2[] = {1, 1, 1, 1, 1, 1, 5, 6, 7, 8, 9, 10, 11, 12, 3, 4, 5, 6, 7, 8, 9, 10, 2, 3, 4, 5, 6, 2, 2, 3, 3, 4, 4, 5, 2, 3, 2, 2, 3, 4, 1, 1};
+        static const int par3[] = {1, 2, 3, 4, 3, 3, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+        static const int par4[] = {0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 3, 3, 4, 4, 5, 4, 6, 4, 0, 0, 0 ,2, 2};
+        static const int par5[] = {0, 0, 0, 0, 1, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 1, 2, 1, 2, 1, 1, 1, 2, 0, 0, 0, 1, 2};
+        static const CardComboType par6[] = {
+            CardComboType::SINGLE, CardComboType::PAIR, CardComboType::TRIPLET, CardComboType::BOMB, CardComboType::TRIPLET1, CardComboType::TRIPLET2,
+            CardComboType::STRAIGHT, CardComboType::STRAIGHT, CardComboType::STRAIGHT, CardComboType::STRAIGHT, CardComboType::STRAIGHT, CardComboType::STRAIGHT, CardComboType::STRAIGHT, CardComboType::STRAIGHT,
+            CardComboType::STRAIGHT2, CardComboType::STRAIGHT2, CardComboType::STRAIGHT2, CardComboType::STRAIGHT2, CardComboType::STRAIGHT2, CardComboType::STRAIGHT2, CardComboType::STRAIGHT2, CardComboType::STRAIGHT2,
+            CardComboType::PLANE, CardComboType::PLANE, CardComboType::PLANE, CardComboType::PLANE, CardComboType::PLANE, CardComboType::PLANE1, CardComboType::PLANE2, CardComboType::PLANE1, CardComboType::PLANE2, CardComboType::PLANE1, CardComboType::PLANE2, CardComboType::PLANE1,
+            CardComboType::SSHUTTLE2, CardComboType::SSHUTTLE2, CardComboType::SSHUTTLE4, CardComboType::SSHUTTLE, CardComboType::SSHUTTLE, CardComboType::SSHUTTLE, CardComboType::QUADRUPLE2, CardComboType::QUADRUPLE4
+        };
+
+        cntlev = 0; for (int i = 0; i < MAX_LEVEL; ++i) if (cnt[i]) ++cntlev;
+        for (int ind = 0; ind < 42; ++ind) {
+            if (total < par1[ind]) continue;
+            if (cntlev < par2[ind] + par4[ind]) continue;
+            bool maxIsStr =
+                par6[ind] == CardComboType::STRAIGHT || par6[ind] == CardComboType::STRAIGHT2 ||
+                par6[ind] == CardComboType::PLANE || par6[ind] == CardComboType::PLANE1 || par6[ind] == CardComboType::PLANE2 ||
+                par6[ind] == CardComboType::SSHUTTLE || par6[ind] == CardComboType::SSHUTTLE2 || par6[ind] == CardComboType::SSHUTTLE4;
+            int cntmain = par2[ind];
+            for (Level lvl = 0; ; ++lvl) {
+                int flag = 0;
+                for (int j = 0; j < cntmain; ++j) {
+                    int lev = lvl + cntmain - 1 - j;
+                    if (
+                        (par6[ind] == CardComboType::SINGLE && lev >= MAX_LEVEL) ||
+                        (par6[ind] != CardComboType::SINGLE && !maxIsStr && lev >= level_joker) ||
+                        (maxIsStr && lev >= MAX_STRAIGHT_LEVEL)
+                    ) {flag = 2; break;}
+                    if (cnt[lev] < par3[ind]) {flag = 1; break;}
+                }
+                if (flag == 1) continue;
+                else if (flag == 2) break;
+                vector<Level> aux; LevelCount reqcnt;
+                int auxcnt = par4[ind];
+                for (int j = 0; j < cntmain; ++j) reqcnt[cntmain - j + lvl - 1] = par3[ind];
+                if (auxcnt == 0) {
+                    CardCombo chCombo = CardCombo(reqcnt);
+                    if (chCombo.comboType == CardComboType::INVALID) continue;
+                    const vector<Card> &chos = chCombo.cards;
+                    double tmpval = 0.0;
+
+                    if (stat == 2 && hist.numOfCards[hist.f2Pos] == 1 && chos.size() == 1 && c2l(chos.back()) <= 3) tmpval += 100.0;
+                    if (stat == 0 && chos.size() <= 3 && (chos.size() == hist.numOfCards[hist.f1Pos] || chos.size() == hist.numOfCards[hist.f2Pos])) {
+                        tmpval -= 100.0; if (chos.size() == 1 || chos.size() == 2) tmpval += (double)c2l(chos.back()) * 2.0;
+                    }
+                    if ((stat == 2 || stat == 3) && chos.size() <= 3 && chos.size() == hist.numOfCards[hist.llPos]) {
+//                        std::cout << chos.size() << ' ' << c2l(chos.front()) + 3 << ' ' << tmpval << '\n';
+                        tmpval -= 100.0; if (chos.size() == 1 || chos.size() == 2) tmpval += (double)c2l(chos.back()) * 2.0;
+                    }
+                    cands.push_back(Candidate(chCombo, cnt - reqcnt, tmpval, -(double)chos.size() * 0.15));
+                } else if (auxcnt > 0) {
+                    for (int k = 0; k < MAX_LEVEL; ++k) {
+                        if (reqcnt[k] || cnt[k] < par5[ind]) continue;
+                        aux.push_back(k);
+                    }
+                    if (aux.size() < auxcnt) continue;
+                    enumKickers(aux, auxcnt, par5[ind], reqcnt, [&](const LevelCount &need, const LevelCount &rem) {
+                        CardCombo chCombo = CardCombo(need);
+                        if (chCombo.comboType == CardComboType::INVALID) return false;
+                        const vector<Card> &chos = chCombo.cards;
+                        double tmpval = 0.0;
+
+                        if (stat == 0 && chos.size() <= 3 && (chos.size() == hist.numOfCards[hist.f1Pos] || chos.size() == hist.numOfCards[hist.f2Pos])) {
+                            tmpval -= 100.0; if (chos.size() == 1 || chos.size() == 2) tmpval += (double)c2l(chos.back()) * 2.0;
+                        }
+                        if ((stat == 2 || stat == 3) && chos.size() <= 3 && chos.size() == hist.numOfCards[hist.llPos]) {
+                            tmpval -= 100.0; if (chos.size() == 1 || chos.size() == 2) tmpval += (double)c2l(chos.back()) * 2.0;
+                        }
+                        cands.push_back(Candidate(chCombo, rem, tmpval, -(double)chos.size() * 0.15));
+                        return false;
+                    });
                 }
             }
+        }
+        pickBest(g, cands, opval, opcntC, optim);
+        for (Level i = 0; i < level_joker; ++i) {
+            if (cnt[i] == 4) {
+                Card bomb[] = {Card(i * 4), Card(i * 4 + 1), Card(i * 4 + 2), Card(i * 4 + 3)};
+                LevelCount rem = cnt; rem[i] = 0;
+
+                vector<Level> oppobomb;
+                for (Level j = 0; j < level_joker; ++j)
+                    if (oppocnt[j] == 4) oppobomb.push_back(j);
+                bool mayDie = false;
+                for (int k = 0; k < oppobomb.size(); ++k) if (oppobomb[k] > i) mayDie = true;
+
+                if (rem.size() == 0 || (CardCombo(rem).comboType != CardComboType::INVALID && !mayDie))
+                    return CardCombo(bomb, bomb + 4);
+            }
+        }
+        if (cnt[level_joker] + cnt[level_JOKER] == 2) {
+            Card rocket[] = {card_joker, card_JOKER};
+            LevelCount rem = cnt; rem[level_joker] = rem[level_JOKER] = 0;
 
-            int whoInHistory[] = {(player.myPos + 1) % 3, (player.myPos + 2) % 3};
-            auto history = request["history"];
-            if (history.isNull()) continue;
-            hist.stage = Stage::PLAYING;
+            if (rem.size() == 0 || (CardCombo(rem).comboType != CardComboType::INVALID))
+                return CardCombo(rocket, rocket + 2);
+        }
+        return optim;
+    } else {
+        ComboSet origin = ComboSet(cnt, oppocnt);
+        double opval = origin.value - 7.0, opcntC = origin.cntC; CardCombo optim = CardCombo();
+        vector<Candidate> cands;
+//        std::cout << opval << ' ' << opcntC << '\n';
+        cntlev = 0; for (int i = 0; i < MAX_LEVEL; ++i) if (cnt[i]) ++cntlev;
+        if ((stat == 1 || stat == 4 || stat == 8 || stat == 5 || stat == 7 || stat == 6) && (minopnum(g) <= 2))
+            opval -= 22.0;
+        if (ltType == CardComboType::ROCKET) return optim;
+        if (total >= lt.cards.size() && unsigned(cntlev) >= lt.packs.size()) {
+            int cntmain = lt.findMaxSeq();
+            bool maxIsStr =
+                ltType == CardComboType::STRAIGHT || ltType == CardComboType::STRAIGHT2 ||
+                ltType == CardComboType::PLANE || ltType == CardComboType::PLANE1 || ltType == CardComboType::PLANE2 ||
+                ltType == CardComboType::SSHUTTLE || ltType == CardComboType::SSHUTTLE2 || ltType == CardComboType::SSHUTTLE4;
+            for (Level lvl = 1; ; ++lvl) {
+                int flag = 0;
+                for (int j = 0; j < cntmain; ++j) {
+                    int lev = lt.packs[j].level + lvl;
+                    if (
+                        (ltType == CardComboType::SINGLE && lev >= MAX_LEVEL) ||
+                        (ltType != CardComboType::SINGLE && !maxIsStr && lev >= level_joker) ||
+                        (maxIsStr && lev >= MAX_STRAIGHT_LEVEL)
+                    ) {flag = 2; break;}
+                    if (cnt[lev] < lt.packs[j].count) {flag = 1; break;}
+                }
+                if (flag == 1) continue;
+                else if (flag == 2) break;
+                vector<Level> aux; LevelCount reqcnt;
+                int auxcnt = lt.packs.size() - cntmain;
+                for (int j = 0; j < cntmain; ++j) reqcnt[lt.packs[j].level + lvl] = lt.packs[j].count;
+
+                if (auxcnt == 0) {
+                    CardCombo chCombo = CardCombo(reqcnt);
+                    if (chCombo.comboType == CardComboType::INVALID) continue;
+                    if (chCombo.cards.size() == total) return chCombo;
+                    const vector<Card> &chos = chCombo.cards;
+                    double tmpval = 0.0;
 
-            int cntPass = 0;
-            for (int p = 0; p < 2; ++p) {
-                int pl = whoInHistory[p];
-                auto playerAction = history[p];
-                vector<Card> playedCards;
-                for (unsigned _ = 0; _ < playerAction.size(); _++) {
-                    int card = playerAction[_].asInt();
-                    playedCards.push_back(card);
+                    if (stat == 6 || stat == 7 || stat == 8)
+                        if (chos.size() == hist.numOfCards[hist.llPos])
+                            tmpval += ((double)c2l(chos.back()) - 11.0);
+                    if (stat == 5 || stat == 6 || stat == 7)
+                        tmpval -= (double)(lt.comboLevel + chCombo.comboLevel - 11);
+                    cands.push_back(Candidate(chCombo, cnt - reqcnt, tmpval, 0.0));
+                } else if (auxcnt > 0) {
+                    for (int k = 0; k < MAX_LEVEL; ++k) {
+                        if (reqcnt[k] || cnt[k] < lt.packs[cntmain].count) continue;
+                        aux.push_back(k);
+                    }
+                    if (aux.size() < auxcnt) continue;
+                    CardCombo finish;
+                    enumKickers(aux, auxcnt, lt.packs[cntmain].count, reqcnt, [&](const LevelCount &need, const LevelCount &rem) {
+                        CardCombo chCombo = CardCombo(need);
+                        if (chCombo.comboType == CardComboType::INVALID) return false;
+                        if (chCombo.cards.size() == total) {finish = chCombo; return true;}
+                        const vector<Card> &chos = chCombo.cards;
+                        double tmpval = 0.0;
+
+                        if (stat == 5 || stat == 6 || stat == 7) tmpval -= (double)(lt.comboLevel + chCombo.comboLevel - 11);
+                        if (stat == 6 || stat == 7 || stat == 8)
+                            if (chos.size() == hist.numOfCards[hist.llPos])
+                                tmpval += ((double)c2l(chos.back()) - 11.0);
+                        cands.push_back(Candidate(chCombo, rem, tmpval, 0.0));
+                        return false;
+                    });
+                    if (finish.comboType != CardComboType::PASS) return finish;
                 }
-                hist.playedCombos[pl].push_back(CardCombo(playedCards.begin(), playedCards.end()));
-//                if (pl == hist.llPos) cout << hist.numOfCards[pl] << '\n';
-                hist.numOfCards[pl] -= playerAction.size();
+            }
+        }
+        pickBest(g, cands, opval, opcntC, optim);
+        for (Level i = 0; i < level_joker; ++i) {
+            if (cnt[i] == 4 && (ltType != CardComboType::BOMB || i > lt.packs[0].level)) {
+                Card bomb[] = {Card(i * 4), Card(i * 4 + 1), Card(i * 4 + 2), Card(i * 4 + 3)};
+                LevelCount rem = cnt; rem[i] = 0;
+                if (rem.size() == 0 || CardCombo(rem).comboType != CardComboType::INVALID)
+                    return CardCombo(bomb, bomb + 4);
+
+                ComboSet remSet = ComboSet(rem, oppocnt);
+                double tmpval = remSet.value, tmpcntC = remSet.cntC;
+
+                if (stat == 6 || stat == 7 || stat == 8)
+                    if (hist.numOfCards[hist.llPos] == lt.cards.size()) tmpval += 12.0;
+                if (stat == 5 || stat == 6 || stat == 7)
+                    tmpval -= 20.0;
+                if ((opval - opcntC * 5.0) < (tmpval - tmpcntC * 5.0)) opval = tmpval, opcntC = tmpcntC, optim = CardCombo(bomb, bomb + 4);
+            }
+        }
+        if (cnt[level_joker] + cnt[level_JOKER] == 2) {
+            Card rocket[] = {card_joker, card_JOKER};
+            LevelCount rem = cnt; rem[level_joker] = rem[level_JOKER] = 0;
+            if (rem.size() == 0 || CardCombo(rem).comboType != CardComboType::INVALID)
+                return CardCombo(rocket, rocket + 2);
+
+            ComboSet remSet = ComboSet(rem, oppocnt);
+            double tmpval = remSet.value, tmpcntC = remSet.cntC;
+            if (stat == 1 && (hist.numOfCards[hist.f1Pos] <= 2 || hist.numOfCards[hist.f2Pos] <= 2)) tmpval += 100.0;
+            if (stat == 6 || stat == 7 || stat == 8)
+                if (hist.numOfCards[hist.llPos] == lt.cards.size()) tmpval += 15.0;
+            if (stat == 5 || stat == 6 || stat == 7)
+                tmpval -= 25.0;
+            if ((opval - opcntC * 5.0) < (tmpval - tmpcntC * 5.0)) opval = tmpval, opcntC = tmpcntC, optim = CardCombo(rocket, rocket + 2);
+        }
+        return optim;
+    }
+}
 
+#ifndef STREAM_INPUT
+#define STREAM_INPUT 0 // 1：标准输入按块 read，每块一到就交给 Json::IncrementalReader，输入读完时 JSON 也解析完了（不走 FastParser）
+#endif
 
-                if (playerAction.size() == 0) ++cntPass;
-                else lastValidCombo = CardCombo(playedCards.begin(), playedCards.end());
+#if FAST_STARTUP || STREAM_INPUT
+#include <unistd.h>
+#endif
+
+namespace BotzoneIO {
+    using namespace std;
+
+#if FAST_STARTUP || STREAM_INPUT
+    string pending; // 按块 read 时多读到的输入，留给下一次读取
+#endif
+
+    // 读入一行（不含换行）；FAST_STARTUP 或 STREAM_INPUT 时按块 read，多读到的内容留给下一行
+    bool readLine(string &line) {
+#if FAST_STARTUP || STREAM_INPUT
+        line.clear();
+        for (;;) {
+            size_t nl = pending.find('\n');
+            if (nl != string::npos) {
+                line.assign(pending, 0, nl), pending.erase(0, nl + 1);
+                return true;
+            }
+            char buf[1 << 16];
+            ssize_t n = ::read(0, buf, sizeof(buf));
+            if (n <= 0) {
+                line.swap(pending), pending.clear();
+                return !line.empty();
             }
+            pending.append(buf, n);
+        }
+#else
+        return bool(getline(cin, line));
+#endif
+    }
 
-            if (cntPass == 2) lastValidCombo = CardCombo();
+    void writeRaw(const char *buf, size_t len) {
+#if FAST_STARTUP
+        for (ssize_t n; len && (n = ::write(1, buf, len)) > 0; ) buf += n, len -= n;
+#else
+        fwrite(buf, 1, len, stdout);
+        fflush(stdout);
+#endif
+    }
 
-            if (i < turn - 1) {
-                auto playerAction = input["responses"][i];
-                vector<Card> playedCards;
-                for (unsigned _ = 0; _ < playerAction.size(); _++) {
-                    int card = playerAction[_].asInt();
-                    playedCards.push_back(card);
-                }
-                hist.playedCombos[player.myPos].push_back(CardCombo(playedCards.begin(), playedCards.end()));
-                hist.numOfCards[player.myPos] -= playerAction.size();
-                player.erase(playedCards.begin(), playedCards.end());
+    // 一条请求里用得到的字段；缺失或为 null 的字段对应的 has* 为 false
+    struct Request {
+        bool hasBid, hasPublic, hasHistory;
+        vector<Card> own, publiccard, history[2];
+        vector<int> bid;
+        int landlord, pos;
+
+        void clear() {
+            hasBid = hasPublic = hasHistory = false;
+            own.clear(), publiccard.clear(), history[0].clear(), history[1].clear(), bid.clear();
+            landlord = pos = 0;
+        }
+
+        bool operator==(const Request &o) const {
+            return hasBid == o.hasBid && hasPublic == o.hasPublic && hasHistory == o.hasHistory &&
+                own == o.own && publiccard == o.publiccard && history[0] == o.history[0] && history[1] == o.history[1] &&
+                bid == o.bid && landlord == o.landlord && pos == o.pos;
+        }
+    };
+
+    // 解析结果；反复使用以保留各 vector 的容量
+    thread_local vector<Request> requests;
+    thread_local vector<vector<Card>> responses;
+    thread_local unsigned numRequests, numResponses;
+
+    // 只认识 Botzone 斗地主输入格式的单遍解析器：数字直接写进 Request，
+    // 不建 DOM。遇到格式之外的结构（非整数、字符串里的转义等）就返回 false，由调用方改用 Json::Reader
+    struct FastParser {
+        const char *p, *end;
+
+        FastParser(const string &s) : p(s.data()), end(s.data() + s.size()) {}
+
+        void ws() {while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;}
+        bool eat(char c) {ws(); if (p < end && *p == c) {++p; return true;} return false;}
+        bool peek(char c) {ws(); return p < end && *p == c;}
+
+        bool literal(const char *lit) {
+            size_t n = strlen(lit);
+            ws();
+            if (size_t(end - p) < n || memcmp(p, lit, n)) return false;
+            p += n;
+            return true;
+        }
+
+        // 牌的编号、叫分和座位都在 0..53 之内；负数、超过两位或大于 53 的数交给 Json::Reader
+        bool integer(int &v) {
+            ws();
+            if (p >= end || *p < '0' || *p > '9') return false;
+            const char *first = p;
+            for (v = 0; p < end && *p >= '0' && *p <= '9'; ++p) {
+                if (p - first == 2) return false;
+                v = v * 10 + (*p - '0');
             }
+            if (p < end && (*p == '.' || *p == 'e' || *p == 'E')) return false;
+            return v <= 53;
         }
-        hist.f1Pos = (hist.llPos + 1) % 3, hist.f2Pos = (hist.llPos + 2) % 3;
-        cntoppo();
+
+        // 不带转义的键名
+        bool key(const char *&k, size_t &len) {
+            if (!eat('"')) return false;
+            k = p;
+            while (p < end && *p != '"' && *p != '\\') ++p;
+            if (p >= end || *p == '\\') return false;
+            len = p++ - k;
+            return eat(':');
+        }
+
+        static bool is(const char *k, size_t len, const char *name) {return strlen(name) == len && !memcmp(k, name, len);}
+
+        template <typename T>
+        bool intArray(vector<T> &out) {
+            out.clear();
+            if (!eat('[')) return false;
+            if (eat(']')) return true;
+            do {
+                int v;
+                if (!integer(v)) return false;
+                out.push_back(v);
+            } while (eat(','));
+            return eat(']');
+        }
+
+        // null 视为字段缺失
+        template <typename T>
+        bool optArray(vector<T> &out, bool &present) {
+            if (literal("null")) {present = false; return true;}
+            present = true;
+            return intArray(out);
+        }
+
+        bool skipString() {
+            if (!eat('"')) return false;
+            for (; p < end; ++p) {
+                if (*p == '\\') {if (++p >= end) return false;}
+                else if (*p == '"') {++p; return true;}
+            }
+            return false;
+        }
+
+        // 跳过不关心的字段的值
+        bool skipValue() {
+            ws();
+            if (p >= end) return false;
+            if (*p == '"') return skipString();
+            if (*p == '{' || *p == '[') {
+                char close = *p == '{' ? '}' : ']';
+                ++p;
+                if (eat(close)) return true;
+                do {
+                    if (close == '}' && (!skipString() || !eat(':'))) return false;
+                    if (!skipValue()) return false;
+                } while (eat(','));
+                return eat(close);
+            }
+            if (literal("true") || literal("false") || literal("null")) return true;
+            if (*p == '-' || (*p >= '0' && *p <= '9')) {
+                ++p;
+                while (p < end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-')) ++p;
+                return true;
+            }
+            return false;
+        }
+
+        bool request(Request &r) {
+            r.clear();
+            if (!eat('{')) return false;
+            if (eat('}')) return true;
+            do {
+                const char *k; size_t len;
+                bool present;
+                if (!key(k, len)) return false;
+                if (is(k, len, "own")) {
+                    if (!optArray(r.own, present)) return false;
+                } else if (is(k, len, "bid")) {
+                    if (!optArray(r.bid, r.hasBid)) return false;
+                } else if (is(k, len, "publiccard")) {
+                    if (!optArray(r.publiccard, r.hasPublic)) return false;
+                } else if (is(k, len, "landlord")) {
+                    if (!integer(r.landlord)) return false;
+                } else if (is(k, len, "pos")) {
+                    if (!integer(r.pos)) return false;
+                } else if (is(k, len, "history")) {
+                    if (literal("null")) {r.hasHistory = false; continue;}
+                    r.hasHistory = true;
+                    if (!eat('[')) return false;
+                    for (int i = 0; !eat(']'); ++i) {
+                        if (i >= 2 || (i > 0 && !eat(','))) return false;
+                        if (!intArray(r.history[i])) return false;
+                    }
+                } else if (!skipValue()) return false;
+            } while (eat(','));
+            return eat('}');
+        }
+
+        // 完整输入：{"requests": [...], "responses": [...], ...}
+        bool input() {
+            numRequests = numResponses = 0;
+            if (!eat('{')) return false;
+            if (eat('}')) return true;
+            do {
+                const char *k; size_t len;
+                if (!key(k, len)) return false;
+                if (is(k, len, "requests")) {
+                    if (!eat('[')) return false;
+                    for (; !eat(']'); ++numRequests) {
+                        if (numRequests && !eat(',')) return false;
+                        if (requests.size() <= numRequests) requests.resize(numRequests + 1);
+                        if (!request(requests[numRequests])) return false;
+                    }
+                } else if (is(k, len, "responses")) {
+                    if (!eat('[')) return false;
+                    for (; !eat(']'); ++numResponses) {
+                        if (numResponses && !eat(',')) return false;
+                        if (responses.size() <= numResponses) responses.resize(numResponses + 1);
+                        responses[numResponses].clear();
+                        // 叫分回合的回应是一个整数，不算出牌
+                        if (peek('[')) {
+                            if (!intArray(responses[numResponses])) return false;
+                        } else {
+                            int v;
+                            if (!integer(v)) return false;
+                        }
+                    }
+                } else if (!skipValue()) return false;
+            } while (eat(','));
+            if (!eat('}')) return false;
+            ws();
+            return p == end;
+        }
+
+        bool single(Request &r) {
+            if (!request(r)) return false;
+            ws();
+            return p == end;
+        }
+    };
+
+    // 备用路径：Json::Reader 解析后转成 Request。只通过 const 引用访问 JSON，
+    // 不复制子树，访问缺失的键也不会插入新节点；该是对象或数组的地方类型不对时当作缺失
+
+    // 把一手牌的 JSON 数组读成牌的列表
+    template <typename T>
+    void readCards(const Json::Value &arr, vector<T> &cards) {
+        cards.clear();
+        if (!arr.isArray()) return;
+        for (unsigned i = 0; i < arr.size(); i++)
+            cards.push_back(arr[i].asInt());
+    }
+
+    // 字段名第一次走备用路径时才驻留（FastParser 能解析的回合不做任何 jsoncpp 的初始化）。
+    // Reader 只查不驻留：解析前先调用 keys()，解析出的同名成员才指向同一份字符串，查找只比较指针
+    // finalbid 不读，但也要驻留：有一个键没驻留，这一层对象的查找就退回按字符串比较
+    struct Keys {
+        Json::StaticKey own, bid, publiccard, landlord, finalbid, pos, history, requests, responses;
+        Keys() : own("own"), bid("bid"), publiccard("publiccard"), landlord("landlord"), finalbid("finalbid"),
+            pos("pos"), history("history"), requests("requests"), responses("responses") {}
+    };
+    const Keys &keys() {static const Keys k; return k;}
+
+    void fromJson(const Json::Value &v, Request &r) {
+        const Keys &key = keys();
+        r.clear();
+        if (!v.isObject()) return;
+        readCards(v[key.own], r.own);
+        const Json::Value &bidHistory = v[key.bid];
+        if ((r.hasBid = !bidHistory.isNull())) readCards(bidHistory, r.bid);
+        const Json::Value &llpublic = v[key.publiccard];
+        if ((r.hasPublic = !llpublic.isNull())) {
+            readCards(llpublic, r.publiccard);
+            r.landlord = v[key.landlord].asInt();
+//            landlordBid = v[key.finalbid].asInt();
+            r.pos = v[key.pos].asInt();
+        }
+        const Json::Value &history = v[key.history];
+        if ((r.hasHistory = !history.isNull()) && history.isArray())
+            for (int p = 0; p < 2; ++p) readCards(history[p], r.history[p]);
+    }
+
+    void fromJson(const Json::Value &input) {
+        const Keys &key = keys();
+        numRequests = numResponses = 0;
+        if (!input.isObject()) return;
+        const Json::Value &reqs = input[key.requests];
+        const Json::Value &resps = input[key.responses];
+        if (reqs.isArray()) numRequests = reqs.size();
+        if (resps.isArray()) numResponses = resps.size();
+        if (requests.size() < numRequests) requests.resize(numRequests);
+        if (responses.size() < numResponses) responses.resize(numResponses);
+        for (unsigned i = 0; i < numRequests; ++i) fromJson(reqs[i], requests[i]);
+        for (unsigned i = 0; i < numResponses; ++i) readCards(resps[i], responses[i]);
+    }
+
+    // 第一条请求：自己的手牌和之前的叫分
+    void readFirst(GameContext &g, const Request &firstRequest) {
+        for (Card c : firstRequest.own)
+            g.player.gain(c);
+        if (firstRequest.hasBid) {
+            g.player.myPos = firstRequest.bid.size();
+            for (int b : firstRequest.bid)
+                g.hist.bids.push_back(b);
+        }
+    }
+
+    // 一条请求：底牌和另外两家的出牌；返回这条请求是否已经在打牌阶段
+    bool applyRequest(GameContext &g, const Request &request) {
+        if (request.hasPublic) {
+            g.hist.llPos = request.landlord;
+            g.player.myPos = request.pos;
+            g.hist.numOfCards[g.hist.llPos] += request.publiccard.size();
+            for (Card c : request.publiccard) {
+                g.hist.pub.push_back(c);
+                if (g.hist.llPos == g.player.myPos)
+                    g.player.gain(c);
+            }
+        }
+
+        int whoInHistory[] = {(g.player.myPos + 1) % 3, (g.player.myPos + 2) % 3};
+        if (!request.hasHistory) return false;
+        g.hist.stage = Stage::PLAYING;
+
+        int cntPass = 0;
+        for (int p = 0; p < 2; ++p) {
+            int pl = whoInHistory[p];
+            const vector<Card> &playedCards = request.history[p];
+            g.hist.playedCombos[pl].push_back(CardCombo(playedCards.begin(), playedCards.end()));
+//            if (pl == g.hist.llPos) cout << g.hist.numOfCards[pl] << '\n';
+            g.hist.numOfCards[pl] -= playedCards.size();
+
+
+            if (playedCards.size() == 0) ++cntPass;
+            else g.lastValidCombo = CardCombo(playedCards.begin(), playedCards.end());
+        }
+
+        if (cntPass == 2) g.lastValidCombo = CardCombo();
+        return true;
+    }
+
+    // 自己打出的一手牌
+    void applyResponse(GameContext &g, const vector<Card> &playedCards) {
+        g.hist.playedCombos[g.player.myPos].push_back(CardCombo(playedCards.begin(), playedCards.end()));
+        g.hist.numOfCards[g.player.myPos] -= playedCards.size();
+        g.player.erase(playedCards.begin(), playedCards.end());
     }
 
-    void bid(int value)
+    void finish(GameContext &g) {
+        g.hist.f1Pos = (g.hist.llPos + 1) % 3, g.hist.f2Pos = (g.hist.llPos + 2) % 3;
+        cntoppo(g);
+    }
+
+    // 由已经读入的 requests/responses 重放出局面
+    void rebuild(GameContext &g) {
+        if (numRequests) readFirst(g, requests[0]);
+
+        for (unsigned i = 0; i < numRequests; ++i) {
+            if (!applyRequest(g, requests[i])) continue;
+            if (i + 1 < numRequests)
+                applyResponse(g, i < numResponses ? responses[i] : vector<Card>());
+        }
+        finish(g);
+    }
+
+    // 由一行完整的 requests/responses 从头重建局面
+    void read(GameContext &g, const string &line) {
+        if (!FastParser(line).input()) {
+            Json::ValueArena arena; // 整棵树从 arena 分配，离开作用域时一次释放；须先于 input 声明
+            Json::Value input;
+            Json::Reader reader(Json::Features::trusted()); // 平台生成的输入：不收注释、不记偏移、出错只记位置
+            keys();
+            reader.parse(line.data(), line.data() + line.size(), input, arena);
+            fromJson(input);
+        }
+        rebuild(g);
+    }
+
+    // 在已有局面上应用本回合的新请求 requests[0]
+    void advance(GameContext &g) {
+        if (g.lastWasPlay) applyResponse(g, g.lastResponse);
+        applyRequest(g, requests[0]);
+        finish(g);
+    }
+
+    // 长时运行模式下的后续回合：平台只发来本回合新的一条请求，在已有局面上增量更新
+    bool readNext(GameContext &g, const string &line) {
+        if (requests.empty()) requests.resize(1);
+        if (!FastParser(line).single(requests[0])) {
+            Json::Value request;
+            Json::Reader reader(Json::Features::trusted());
+            keys();
+            if (!reader.parse(line, request)) return false;
+            fromJson(request, requests[0]);
+        }
+        advance(g);
+        return true;
+    }
+
+#if STREAM_INPUT
+    // 读入下一份 JSON：已缓冲的输入先交给解析器，不够再按块 read，每块到了就接着解析，
+    // 所以最后一个字节到达时树也建好了。这份 JSON 之后多读到的字节留在 pending 里
+    bool readJson(Json::Value &root) {
+        Json::IncrementalReader reader(Json::Features::trusted());
+        keys();
+        reader.reset(root);
+        const char *stop = reader.feed(pending.data(), pending.data() + pending.size());
+        pending.erase(0, stop - pending.data());
+        char buf[1 << 16];
+        for (ssize_t n; !reader.done() && !reader.failed() && (n = ::read(0, buf, sizeof(buf))) > 0; ) {
+            stop = reader.feed(buf, buf + n);
+            pending.assign(stop, buf + n - stop);
+        }
+        return reader.finish();
+    }
+
+    // 第一回合：边读边解析完整的 requests/responses，再重建局面；输入不完整或有语法错误时返回 false
+    bool read(GameContext &g) {
+        Json::Value input;
+        if (!readJson(input)) return false;
+        fromJson(input);
+        rebuild(g);
+        return true;
+    }
+
+    bool readNext(GameContext &g) {
+        Json::Value request;
+        if (!readJson(request)) return false;
+        if (requests.empty()) requests.resize(1);
+        fromJson(request, requests[0]);
+        advance(g);
+        return true;
+    }
+#else
+    bool readNext(GameContext &g) {
+        string line;
+        return readLine(line) && readNext(g, line);
+    }
+#endif
+
+    // 长时运行模式下每回合回应之后的标记
+    void keepRunning() {
+        const char marker[] = ">>>BOTZONE_REQUEST_KEEP_RUNNING<<<\n";
+        writeRaw(marker, sizeof(marker) - 1);
+    }
+
+    // 回应直接格式化进栈上缓冲区，一次写出；格式与 Json::FastWriter 加 endl 逐字节相同：
+    // {"response":X}\n\n
+    char *writeInt(char *out, int v) {
+        char tmp[12];
+        int n = 0;
+        unsigned u = v < 0 ? 0u - unsigned(v) : unsigned(v);
+        do tmp[n++] = char('0' + u % 10); while (u /= 10);
+        if (v < 0) *out++ = '-';
+        while (n) *out++ = tmp[--n];
+        return out;
+    }
+
+    const char responseHead[] = "{\"response\":";
+
+    // 不为空时回应追加到这里而不直接输出，并去掉末尾的空行（批量模式每行一个回应）
+    thread_local string *captured = nullptr;
+
+    void writeResponse(const char *buf, size_t len) {
+        if (captured) {captured->append(buf, len - 1); return;}
+        writeRaw(buf, len);
+    }
+
+    void bid(GameContext &g, int value)
     {
-        Json::Value result;
-        result["response"] = value;
+        char buf[32], *out = buf + sizeof(responseHead) - 1;
+        g.lastWasPlay = false;
 
-        Json::FastWriter writer;
-        cout << writer.write(result) << endl;
+        memcpy(buf, responseHead, sizeof(responseHead) - 1);
+        out = writeInt(out, value);
+        memcpy(out, "}\n\n", 3);
+        writeResponse(buf, out + 3 - buf);
     }
 
     template <typename CARD_ITERATOR>
-    void play(CARD_ITERATOR begin, CARD_ITERATOR end)
+    void play(GameContext &g, CARD_ITERATOR begin, CARD_ITERATOR end)
     {
-        Json::Value result, response(Json::arrayValue);
-        for (; begin != end; begin++)
-            response.append(*begin);
-        result["response"] = response;
-
-        Json::FastWriter writer;
-        cout << writer.write(result) << endl;
+        // 一手最多 54 张，每张至多 "53," 三字节
+        char buf[sizeof(responseHead) + 54 * 3 + 8], *out = buf + sizeof(responseHead) - 1;
+        g.lastResponse.assign(begin, end), g.lastWasPlay = true;
+
+        memcpy(buf, responseHead, sizeof(responseHead) - 1);
+        *out++ = '[';
+        for (bool first = true; begin != end; begin++, first = false) {
+            if (!first) *out++ = ',';
+            out = writeInt(out, *begin);
+        }
+        memcpy(out, "]}\n\n", 4);
+        writeResponse(buf, out + 4 - buf);
     }
 }
 
-int main() {
-    srand(time(nullptr));
-    BotzoneIO::read();
+#ifndef KEEP_RUNNING
+#define KEEP_RUNNING 0 // 1：长时运行，回合之间进程不退出，之后每回合只读入新的一条请求
+#endif
 
-    if (hist.stage == Stage::BIDDING) {
+void respond(GameContext &g) {
+    if (g.hist.stage == Stage::BIDDING) {
         int maxbid = -1;
-        for (int i = 0; i < hist.bids.size(); ++i) maxbid = (maxbid < hist.bids[i] ? hist.bids[i] : maxbid);
-        ComboSet S = ComboSet(player.myCards.begin(), player.myCards.end());
+        for (int i = 0; i < g.hist.bids.size(); ++i) maxbid = (maxbid < g.hist.bids[i] ? g.hist.bids[i] : maxbid);
+        ComboSet S = ComboSet(g.player.cnt, g.oppocnt);
         double v = S.value - S.cntC * 5.0;
-        if (v < -55.0) BotzoneIO::bid(0);
-        else if (v < -40.0) BotzoneIO::bid(maxbid >= 1 ? 0 : 1);
-        else if (v < -25.0) BotzoneIO::bid(maxbid >= 2 ? 0 : 2);
-        else BotzoneIO::bid(3);
+        if (v < -55.0) BotzoneIO::bid(g, 0);
+        else if (v < -40.0) BotzoneIO::bid(g, maxbid >= 1 ? 0 : 1);
+        else if (v < -25.0) BotzoneIO::bid(g, maxbid >= 2 ? 0 : 2);
+        else BotzoneIO::bid(g, 3);
     }
-    else if (hist.stage == Stage::PLAYING) {
-        CardCombo myAction = player.action(lastValidCombo, status());
-        BotzoneIO::play(myAction.cards.begin(), myAction.cards.end());
+    else if (g.hist.stage == Stage::PLAYING) {
+        CardCombo myAction = g.player.action(g, g.lastValidCombo, status(g));
+        BotzoneIO::play(g, myAction.cards.begin(), myAction.cards.end());
     }
+}
+
+#ifndef BATCH
+#define BATCH 0 // 1：离线批量评估，stdin 每行是一份完整的 Botzone 输入，stdout 每行输出对应的回应
+#endif
+#ifndef BATCH_THREADS
+#define BATCH_THREADS 1 // 批量模式的工作线程数，0 表示取 CPU 核数
+#endif
+#ifndef BATCH_CHUNK
+#define BATCH_CHUNK 1024 // 批量模式每次读入并分给各线程的行数
+#endif
+
+// 批量模式：按块读入若干行，各行独立地重建局面并决策，输出顺序和输入一致
+void runBatch() {
+    unsigned n = BATCH_THREADS ? BATCH_THREADS : std::max(1u, std::thread::hardware_concurrency());
+    ThreadPool lines(n);
+    vector<string> in(BATCH_CHUNK), out(BATCH_CHUNK);
+    for (;;) {
+        unsigned cnt = 0;
+        while (cnt < in.size() && BotzoneIO::readLine(in[cnt])) ++cnt;
+        if (!cnt) break;
+        auto one = [&](unsigned i) {
+            GameContext g;
+            out[i].clear();
+            BotzoneIO::captured = &out[i];
+            BotzoneIO::read(g, in[i]);
+            respond(g);
+            BotzoneIO::captured = nullptr;
+        };
+        if (lines.size() > 1) lines.parallelFor(cnt, one);
+        else for (unsigned i = 0; i < cnt; ++i) one(i);
+        for (unsigned i = 0; i < cnt; ++i) fwrite(out[i].data(), 1, out[i].size(), stdout);
+        fflush(stdout);
+        if (cnt < in.size()) break;
+    }
+}
+
+#ifndef ARENA
+#define ARENA 0 // 1：本地裁判，按 Botzone 规则让三个座位对局，统计吞吐、每步耗时和各身份胜率
+#endif
+
+#if ARENA
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <random>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace Arena {
+    using namespace std;
+
+    // 一个座位上的 bot：path 为空时在本进程内决策，否则每回合启动一次外部程序，
+    // 两者收到的都是同一份 Botzone JSON 输入
+    struct Bot {
+        string path;
+
+        string ask(const string &input) const {
+            if (path.empty()) {
+                GameContext g;
+                string out;
+                BotzoneIO::captured = &out;
+                BotzoneIO::read(g, input);
+                respond(g);
+                BotzoneIO::captured = nullptr;
+                return out;
+            }
+            int in[2], out[2];
+            if (pipe(in)) return "";
+            if (pipe(out)) {close(in[0]), close(in[1]); return "";}
+            pid_t pid = fork();
+            if (pid == 0) {
+                dup2(in[0], 0), dup2(out[1], 1);
+                close(in[0]), close(in[1]), close(out[0]), close(out[1]);
+                execl(path.c_str(), path.c_str(), (char *)nullptr);
+                _exit(127);
+            }
+            close(in[0]), close(out[1]);
+            string line = input + "\n", res;
+            for (size_t done = 0; pid > 0 && done < line.size(); ) {
+                ssize_t n = write(in[1], line.data() + done, line.size() - done);
+                if (n <= 0) break;
+                done += n;
+            }
+            close(in[1]);
+            char buf[4096];
+            for (ssize_t n; pid > 0 && (n = read(out[0], buf, sizeof(buf))) > 0; ) res.append(buf, n);
+            close(out[0]);
+            if (pid > 0) waitpid(pid, nullptr, 0);
+            return res;
+        }
+    };
+
+    template <typename T>
+    string listJson(const vector<T> &v) {
+        string s = "[";
+        for (unsigned i = 0; i < v.size(); ++i) s += (i ? "," : "") + to_string(v[i]);
+        return s + "]";
+    }
+
+    // 取出回应里的 response 字段
+    bool parseResponse(const string &out, Json::Value &resp) {
+        Json::Value v;
+        Json::Reader reader(Json::Features::trusted());
+        if (!reader.parse(out.substr(0, out.find('\n')), v) || !v.isObject()) return false;
+        resp = std::move(v["response"]); // 不再深拷贝整棵 response
+        return true;
+    }
+
+    struct GameResult {
+        bool dealt = false;         // 是否发出了有效的一局（叫分阶段非法时为 false）
+        int landlord = 0, finalBid = 1, bombs = 0, winner = -1, illegal = -1;
+        bool spring = false;
+        vector<double> latency;     // 每次询问 bot 的耗时，微秒
+    };
+
+    // 一局：发牌、叫分、出牌，非法回应判该方负
+    GameResult play(const Bot bots[3], unsigned seed) {
+        GameResult res;
+        mt19937 rng(seed);
+        vector<Card> deck(54);
+        for (int i = 0; i < 54; ++i) deck[i] = i;
+        shuffle(deck.begin(), deck.end(), rng);
+        vector<Card> hands[3], pub(deck.begin() + 51, deck.end());
+        for (int s = 0; s < 3; ++s) hands[s].assign(deck.begin() + 17 * s, deck.begin() + 17 * s + 17), sort(hands[s].begin(), hands[s].end());
+
+        vector<string> reqs[3], resps[3];
+        auto ask = [&](int seat, Json::Value &resp) {
+            string input = "{\"requests\":[";
+            for (unsigned i = 0; i < reqs[seat].size(); ++i) input += (i ? "," : "") + reqs[seat][i];
+            input += "],\"responses\":[";
+            for (unsigned i = 0; i < resps[seat].size(); ++i) input += (i ? "," : "") + resps[seat][i];
+            input += "]}";
+            auto t = chrono::steady_clock::now();
+            string out = bots[seat].ask(input);
+            res.latency.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - t).count());
+            return parseResponse(out, resp);
+        };
+
+        // 叫分：依次叫 0 或比之前都高的分，叫到 3 分立即结束；都不叫时 0 号位以 1 分当地主
+        vector<int> bids;
+        for (int s = 0; s < 3; ++s) {
+            reqs[s].push_back("{\"own\":" + listJson(hands[s]) + ",\"bid\":" + listJson(bids) + "}");
+            Json::Value resp;
+            int maxbid = bids.empty() ? 0 : *max_element(bids.begin(), bids.end());
+            if (!ask(s, resp) || !resp.isInt() || resp.asInt() < 0 || resp.asInt() > 3 || (resp.asInt() && resp.asInt() <= maxbid)) {
+                res.illegal = s;
+                return res;
+            }
+            bids.push_back(resp.asInt()), resps[s].push_back(to_string(resp.asInt()));
+            if (bids.back() == 3) break;
+        }
+        int maxbid = *max_element(bids.begin(), bids.end());
+        res.dealt = true;
+        res.landlord = maxbid ? max_element(bids.begin(), bids.end()) - bids.begin() : 0;
+        res.finalBid = maxbid ? maxbid : 1;
+        const int ll = res.landlord;
+        bool asked[3] = {}, first[3] = {true, true, true};
+        for (int s = 0; s < 3; ++s) asked[s] = !reqs[s].empty();
+        vector<Card> own[3] = {hands[0], hands[1], hands[2]};
+        hands[ll].insert(hands[ll].end(), pub.begin(), pub.end());
+
+        // 出牌：history 是自己上次出牌之后另外两家（下家、上家）各自的出牌
+        vector<Card> last[3];
+        CardCombo facing;
+        int facingSeat = -1, playsBy[3] = {};
+        for (int cur = ll; ; cur = (cur + 1) % 3) {
+            string r = "{\"history\":[" + listJson(last[(cur + 1) % 3]) + "," + listJson(last[(cur + 2) % 3]) + "]";
+            if (!asked[cur]) r += ",\"own\":" + listJson(own[cur]), asked[cur] = true;
+            if (first[cur]) {
+                r += ",\"publiccard\":" + listJson(pub) + ",\"landlord\":" + to_string(ll) + ",\"pos\":" + to_string(cur) + ",\"finalbid\":" + to_string(res.finalBid);
+                first[cur] = false;
+            }
+            reqs[cur].push_back(r + "}");
+
+            Json::Value resp;
+            vector<Card> chos;
+            bool ok = ask(cur, resp) && resp.isArray();
+            for (unsigned i = 0; ok && i < resp.size(); ++i) {
+                if (!resp[i].isInt()) {ok = false; break;}
+                chos.push_back(resp[i].asInt());
+            }
+            // 出的牌必须都在手里、牌型合法，并且能压过要压的牌（轮到自己领出时不能过）
+            vector<Card> rest = hands[cur];
+            for (unsigned i = 0; ok && i < chos.size(); ++i) {
+                auto it = find(rest.begin(), rest.end(), chos[i]);
+                if (it == rest.end()) ok = false;
+                else rest.erase(it);
+            }
+            CardCombo cc(chos.begin(), chos.end());
+            bool leading = facingSeat < 0 || facingSeat == cur;
+            if (ok) ok = leading ? cc.comboType != CardComboType::PASS && cc.comboType != CardComboType::INVALID
+                                 : cc.comboType == CardComboType::PASS || facing < cc;
+            if (!ok) {
+                res.illegal = cur;
+                res.winner = cur == ll ? (ll + 1) % 3 : ll;
+                return res;
+            }
+
+            resps[cur].push_back(listJson(chos));
+            last[cur] = chos, hands[cur] = rest;
+            if (cc.comboType == CardComboType::PASS) continue;
+            facing = cc, facingSeat = cur, ++playsBy[cur];
+            if (cc.comboType == CardComboType::BOMB || cc.comboType == CardComboType::ROCKET) ++res.bombs;
+            if (hands[cur].empty()) {
+                res.winner = cur;
+                res.spring = cur == ll ? playsBy[(ll + 1) % 3] + playsBy[(ll + 2) % 3] == 0 : playsBy[ll] == 1;
+                return res;
+            }
+        }
+    }
+
+    double percentile(const vector<double> &v, double q) {
+        return v.empty() ? 0.0 : v[min(v.size() - 1, size_t(q * v.size()))];
+    }
+
+    // 冷启动耗时：对每行输入各启动一次外部 bot，从 fork 到读完回应计时，叫分和出牌分开统计
+    int coldStart(const char *path, const char *inputs, unsigned repeat) {
+        std::ifstream in(inputs);
+        if (!in) {fprintf(stderr, "cannot open %s\n", inputs); return 1;}
+        vector<string> lines;
+        for (string line; getline(in, line); ) lines.push_back(line);
+        Bot bot{path};
+        vector<double> lat[2];
+        for (unsigned r = 0; r < repeat; ++r)
+            for (const string &line : lines) {
+                auto t = chrono::steady_clock::now();
+                string out = bot.ask(line);
+                double us = chrono::duration<double, micro>(chrono::steady_clock::now() - t).count();
+                Json::Value resp;
+                if (parseResponse(out, resp)) lat[resp.isArray()].push_back(us);
+            }
+        const char *names[] = {"bid", "play"};
+        for (int k = 0; k < 2; ++k) {
+            sort(lat[k].begin(), lat[k].end());
+            printf("%s: %zu runs, cold start to response us: p50 %.0f p90 %.0f p99 %.0f\n", names[k], lat[k].size(),
+                   percentile(lat[k], 0.5), percentile(lat[k], 0.9), percentile(lat[k], 0.99));
+        }
+        return 0;
+    }
+
+    // 用法：arena [局数] [线程数] [0 号位 bot] [1 号位 bot] [2 号位 bot]
+    // bot 为 - 或缺省时用本进程内的 bot；第 i 局用种子 i 发牌，结果可复现
+    //       arena coldstart <bot> <输入.jsonl> [重复次数]    测量外部 bot 每回合一个进程时的启动到回应耗时
+    int run(int argc, char *argv[]) {
+        signal(SIGPIPE, SIG_IGN);
+        if (argc >= 4 && !strcmp(argv[1], "coldstart")) return coldStart(argv[2], argv[3], argc > 4 ? atoi(argv[4]) : 1);
+        unsigned games = argc > 1 ? atoi(argv[1]) : 100;
+        unsigned threads = argc > 2 ? atoi(argv[2]) : 1;
+        if (!threads) threads = max(1u, thread::hardware_concurrency());
+        Bot bots[3];
+        for (int s = 0; s < 3; ++s)
+            if (argc > 3 + s && strcmp(argv[3 + s], "-")) bots[s].path = argv[3 + s];
+
+        vector<GameResult> results(games);
+        ThreadPool pool(threads);
+        auto start = chrono::steady_clock::now();
+        pool.parallelFor(games, [&](unsigned i) {results[i] = play(bots, i);});
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        // 身份：0 地主，1 地主下家，2 地主上家
+        unsigned played[3][3] = {}, won[3][3] = {}, dealt = 0, illegal = 0, llWins = 0;
+        double llScore = 0.0;
+        vector<double> lat;
+        for (const GameResult &r : results) {
+            lat.insert(lat.end(), r.latency.begin(), r.latency.end());
+            if (r.illegal >= 0) ++illegal;
+            if (!r.dealt || r.winner < 0) continue;
+            ++dealt;
+            bool llWin = r.winner == r.landlord;
+            int score = r.finalBid << (r.bombs + r.spring);
+            llWins += llWin, llScore += llWin ? 2 * score : -2 * score;
+            for (int s = 0; s < 3; ++s) {
+                int role = (s - r.landlord + 3) % 3;
+                ++played[s][role];
+                if ((role == 0) == llWin) ++won[s][role];
+            }
+        }
+        sort(lat.begin(), lat.end());
+        printf("games %u (finished %u, illegal %u) in %.2fs, %.1f games/s, %u threads\n", games, dealt, illegal, secs, games / secs, pool.size());
+        printf("move latency us: p50 %.0f p90 %.0f p99 %.0f max %.0f (%zu moves)\n",
+               percentile(lat, 0.5), percentile(lat, 0.9), percentile(lat, 0.99), lat.empty() ? 0.0 : lat.back(), lat.size());
+        printf("landlord win rate %.3f, avg landlord score %.2f\n", dealt ? double(llWins) / dealt : 0.0, dealt ? llScore / dealt : 0.0);
+        const char *roles[] = {"landlord", "farmer(next)", "farmer(prev)"};
+        for (int s = 0; s < 3; ++s) {
+            printf("seat %d %s:", s, bots[s].path.empty() ? "(in-process)" : bots[s].path.c_str());
+            for (int role = 0; role < 3; ++role)
+                printf("  %s %u/%u %.3f", roles[role], won[s][role], played[s][role], played[s][role] ? double(won[s][role]) / played[s][role] : 0.0);
+            printf("\n");
+        }
+        return 0;
+    }
+}
+#endif
+
+#ifndef RECORD_TOOL
+#define RECORD_TOOL 0 // 1：对局记录工具，把 Botzone 日志转成紧凑的二进制记录，并在记录上逐个局面重放
+#endif
+
+#if RECORD_TOOL
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Record {
+    using namespace std;
+
+    typedef uint64_t Mask;      // 第 c 位表示牌 c
+
+    // 文件：8 字节魔数，之后是首尾相接的记录。每条记录是一个 Header 加 turns 个出牌掩码，都按 8 字节对齐
+    const char MAGIC[8] = "FTLREC1";
+
+    struct Header {
+        Mask hands[3];          // 三家发到的 17 张牌（不含底牌）
+        Mask pub;               // 底牌
+        uint8_t bids[3];        // 各家叫分，没轮到叫的为 0xFF
+        uint8_t landlord, finalBid;
+        int8_t winner;          // 先出完牌的座位，-1 表示没打完
+        uint16_t turns;         // 第 t 手由 (landlord + t) % 3 号位出，掩码为 0 表示过
+    };
+    static_assert(sizeof(Header) == 40, "记录头应为 40 字节");
+
+    template <typename T>
+    Mask toMask(const vector<T> &cards) {
+        Mask m = 0;
+        for (T c : cards) m |= Mask(1) << c;
+        return m;
+    }
+
+    void fromMask(Mask m, vector<Card> &cards) {
+        cards.clear();
+        for (; m; m &= m - 1) cards.push_back(__builtin_ctzll(m));
+    }
+
+    // 两手牌是否只差在同点数牌的花色上
+    bool sameLevels(Mask a, Mask b) {
+        for (int l = 0; l < 13; ++l)
+            if (__builtin_popcountll(a >> (4 * l) & 0xF) != __builtin_popcountll(b >> (4 * l) & 0xF)) return false;
+        return a >> 52 == b >> 52;
+    }
+
+    unsigned numBids(const Header &h) {
+        unsigned n = 0;
+        while (n < 3 && h.bids[n] != 0xFF) ++n;
+        return n;
+    }
+
+    // 一局里可以重放的局面数：先是各次叫分，然后是各手出牌
+    unsigned positions(const Header &h) {return numBids(h) + h.turns;}
+
+    // 日志里的字段名，同 BotzoneIO::Keys 一样第一次用到时才驻留（同名的键驻留到同一份字符串）
+    struct LogKeys {
+        Json::StaticKey log, output, content, response, own, publiccard, landlord, finalbid, seat[3];
+        LogKeys() : log("log"), output("output"), content("content"), response("response"),
+            own("own"), publiccard("publiccard"), landlord("landlord"), finalbid("finalbid"),
+            seat{Json::StaticKey("0"), Json::StaticKey("1"), Json::StaticKey("2")} {}
+    };
+    const LogKeys &logKeys() {static const LogKeys k; return k;}
+
+    // 由一份 Botzone 对局日志（{"log": [...]}）还原一条记录：裁判的 request 里有各家手牌、底牌和地主，
+    // 玩家的 response 依次是叫分和出牌。缺信息或者出牌对不上时返回 false
+    bool fromLog(const Json::Value &root, Header &h, vector<Mask> &plays) {
+        const LogKeys &key = logKeys();
+        const Json::Value &log = root.isObject() ? root[key.log] : root;
+        memset(&h, 0, sizeof(h));
+        memset(h.bids, 0xFF, sizeof(h.bids));
+        h.winner = -1;
+        plays.clear();
+        bool haveHand[3] = {}, haveLandlord = false;
+        unsigned bids = 0;
+        vector<Card> cards;
+        for (unsigned i = 0; i < log.size(); ++i) {
+            const Json::Value &entry = log[i];
+            if (!entry.isObject()) return false;
+            const Json::Value &output = entry[key.output];
+            for (int s = 0; s < 3; ++s) {
+                if (!output.isNull()) {
+                    const Json::Value &req = output[key.content][key.seat[s]];
+                    if (!req.isObject()) continue;
+                    if (req.isMember(key.own)) BotzoneIO::readCards(req[key.own], cards), h.hands[s] = toMask(cards), haveHand[s] = true;
+                    if (req.isMember(key.publiccard)) {
+                        BotzoneIO::readCards(req[key.publiccard], cards), h.pub = toMask(cards);
+                        h.landlord = req[key.landlord].asInt(), haveLandlord = true;
+                        h.finalBid = req.isMember(key.finalbid) ? req[key.finalbid].asInt() : 1;
+                    }
+                } else {
+                    const Json::Value &resp = entry[key.seat[s]][key.response];
+                    if (resp.isInt()) {
+                        if (bids >= 3 || unsigned(s) != bids) return false;
+                        h.bids[bids++] = resp.asInt();
+                    } else if (resp.isArray()) {
+                        if (!haveLandlord || unsigned(s) != (h.landlord + plays.size()) % 3) return false;
+                        BotzoneIO::readCards(resp, cards);
+                        plays.push_back(toMask(cards));
+                    }
+                }
+            }
+        }
+        if (!haveLandlord || h.landlord > 2) return false;
+        // 早早结束的对局里可能有人没收到过手牌，用补集还原
+        int missing = 0, who = -1;
+        Mask all = h.pub;
+        for (int s = 0; s < 3; ++s)
+            if (haveHand[s]) all |= h.hands[s];
+            else ++missing, who = s;
+        if (missing > 1) return false;
+        if (missing) h.hands[who] = ((Mask(1) << 54) - 1) & ~all;
+
+        Mask left[3] = {h.hands[0], h.hands[1], h.hands[2]};
+        left[h.landlord] |= h.pub;
+        for (unsigned t = 0; t < plays.size(); ++t) {
+            int s = (h.landlord + t) % 3;
+            if ((plays[t] & left[s]) != plays[t]) return false;
+            left[s] &= ~plays[t];
+            if (!left[s]) {h.winner = s; plays.resize(t + 1); break;}
+        }
+        h.turns = plays.size();
+        return true;
+    }
+
+    void write(FILE *f, const Header &h, const vector<Mask> &plays) {
+        fwrite(&h, sizeof(h), 1, f);
+        fwrite(plays.data(), sizeof(Mask), plays.size(), f);
+    }
+
+    // 只读映射整个文件，按顺序遍历记录；返回的指针直接指向映射的内存，遍历时不分配
+    struct Reader {
+        const char *base = nullptr;
+        size_t len = 0, off = sizeof(MAGIC);
+        int fd = -1;
+
+        bool open(const char *path) {
+            struct stat st;
+            if ((fd = ::open(path, O_RDONLY)) < 0 || fstat(fd, &st) || size_t(st.st_size) < sizeof(MAGIC)) return false;
+            len = st.st_size;
+            void *p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) return false;
+            base = (const char *)p;
+            madvise(p, len, MADV_SEQUENTIAL);
+            return !memcmp(base, MAGIC, sizeof(MAGIC));
+        }
+
+        ~Reader() {
+            if (base) munmap((void *)base, len);
+            if (fd >= 0) close(fd);
+        }
+
+        bool next(const Header *&h, const Mask *&plays) {
+            if (off + sizeof(Header) > len) return false;
+            h = (const Header *)(base + off);
+            plays = (const Mask *)(base + off + sizeof(Header));
+            if (off + sizeof(Header) + h->turns * sizeof(Mask) > len) return false;
+            off += sizeof(Header) + h->turns * sizeof(Mask);
+            return true;
+        }
+    };
+
+    // 把局面还原成该座位在 Botzone 上会看到的样子：逐条构造它收到的请求，交给 BotzoneIO 的同一套更新函数，
+    // 所以得到的 History 和 Player 与读入 JSON 时完全一致。req 是复用的缓冲区。返回该局面轮到的座位
+    int view(const Header &h, const Mask *plays, unsigned pos, GameContext &g, BotzoneIO::Request &req) {
+        g = GameContext();
+        unsigned nb = numBids(h);
+        if (pos < nb) {
+            req.clear();
+            fromMask(h.hands[pos], req.own);
+            req.hasBid = true;
+            for (unsigned i = 0; i < pos; ++i) req.bid.push_back(h.bids[i]);
+            BotzoneIO::readFirst(g, req);
+            BotzoneIO::applyRequest(g, req);
+            BotzoneIO::finish(g);
+            return pos;
+        }
+        unsigned turn = pos - nb;
+        int seat = (h.landlord + turn) % 3;
+        bool bidder = unsigned(seat) < nb;
+        if (bidder) {
+            req.clear();
+            fromMask(h.hands[seat], req.own);
+            req.hasBid = true;
+            for (int i = 0; i < seat; ++i) req.bid.push_back(h.bids[i]);
+            BotzoneIO::readFirst(g, req);
+        }
+        for (unsigned u = turn % 3; u <= turn; u += 3) {
+            req.clear();
+            req.hasHistory = true;
+            if (u >= 2) fromMask(plays[u - 2], req.history[0]);
+            if (u >= 1) fromMask(plays[u - 1], req.history[1]);
+            if (u < 3) {
+                fromMask(h.pub, req.publiccard);
+                req.hasPublic = true, req.landlord = h.landlord, req.pos = seat;
+                if (!bidder) fromMask(h.hands[seat], req.own), BotzoneIO::readFirst(g, req);
+            }
+            BotzoneIO::applyRequest(g, req);
+            if (u < turn) {
+                fromMask(plays[u], req.own);
+                BotzoneIO::applyResponse(g, req.own);
+            }
+        }
+        BotzoneIO::finish(g);
+        return seat;
+    }
+
+    // 每行一份完整的 Botzone 输入：先核对 FastParser 和 Json::Reader + fromJson 解析出的请求一致，
+    // 再各自重复 repeat 遍计时。FastParser 不接受的行不参与核对，计时时照常走备用路径
+    int parse(const char *inputs, unsigned repeat) {
+        std::ifstream in(inputs);
+        if (!in) {fprintf(stderr, "cannot open %s\n", inputs); return 1;}
+        vector<string> lines;
+        size_t bytes = 0;
+        for (string line; getline(in, line); )
+            if (!line.empty()) bytes += line.size(), lines.push_back(line);
+        if (lines.empty()) {fprintf(stderr, "no input in %s\n", inputs); return 1;}
+
+        using BotzoneIO::requests; using BotzoneIO::responses; using BotzoneIO::numRequests; using BotzoneIO::numResponses;
+        auto viaReader = [](const string &line) {
+            Json::ValueArena arena;
+            Json::Value input;
+            Json::Reader reader(Json::Features::trusted());
+            reader.parse(line.data(), line.data() + line.size(), input, arena);
+            BotzoneIO::fromJson(input);
+        };
+        unsigned fast = 0, differ = 0;
+        vector<BotzoneIO::Request> reqs;
+        vector<vector<Card>> resps;
+        for (const string &line : lines) {
+            if (!BotzoneIO::FastParser(line).input()) continue;
+            ++fast;
+            reqs.assign(requests.begin(), requests.begin() + numRequests);
+            resps.assign(responses.begin(), responses.begin() + numResponses);
+            viaReader(line);
+            bool same = reqs.size() == numRequests && resps.size() == numResponses;
+            for (unsigned i = 0; same && i < numRequests; ++i) same = reqs[i] == requests[i];
+            for (unsigned i = 0; same && i < numResponses; ++i) same = resps[i] == responses[i];
+            differ += !same;
+        }
+
+        double secs[2] = {};
+        for (int k = 0; k < 2; ++k) {
+            auto t = chrono::steady_clock::now();
+            for (unsigned r = 0; r < repeat; ++r)
+                for (const string &line : lines)
+                    if (k || !BotzoneIO::FastParser(line).input()) viaReader(line);
+            secs[k] = chrono::duration<double>(chrono::steady_clock::now() - t).count();
+        }
+        double n = double(lines.size()) * repeat;
+        printf("inputs %zu (avg %.0f bytes), fast path %u, mismatch %u\n", lines.size(), double(bytes) / lines.size(), fast, differ);
+        printf("fast parser %.2f us/input, Json::Reader + fromJson %.2f us/input\n", secs[0] * 1e6 / n, secs[1] * 1e6 / n);
+        return differ ? 1 : 0;
+    }
+
+    // 每行一份 JSON：Json::IncrementalReader 按 1、3、7 字节和整行切块喂入，是否成功和得到的树都应和 Json::Reader 一致。
+    // 默认 Features 和 Features::trusted() 各核对一遍
+    int chunks(const char *inputs) {
+        std::ifstream in(inputs);
+        if (!in) {fprintf(stderr, "cannot open %s\n", inputs); return 1;}
+        const Json::Features features[] = {Json::Features(), Json::Features::trusted()};
+        const size_t sizes[] = {1, 3, 7, 0}; // 0 表示整行一次喂入
+        unsigned lines = 0, checks = 0, differ = 0;
+        for (string line; getline(in, line); ++lines)
+            for (const Json::Features &f : features) {
+                Json::Value expected;
+                Json::Reader reader(f);
+                bool ok = reader.parse(line, expected);
+                for (size_t size : sizes) {
+                    Json::Value root;
+                    Json::IncrementalReader inc(f);
+                    inc.reset(root);
+                    const char *p = line.data(), *end = p + line.size();
+                    while (p < end && !inc.done() && !inc.failed()) {
+                        const char *next = size && size_t(end - p) > size ? p + size : end;
+                        inc.feed(p, next);
+                        p = next;
+                    }
+                    bool got = inc.finish();
+                    ++checks;
+                    if (got != ok || (ok && !(root == expected))) {
+                        if (!differ) fprintf(stderr, "line %u, chunk %zu: %s\n", lines + 1, size, !ok ? "only Reader rejects" : !got ? "only IncrementalReader rejects" : "tree differs");
+                        ++differ;
+                    }
+                }
+            }
+        printf("lines %u, checks %u, mismatch %u\n", lines, checks, differ);
+        return differ ? 1 : 0;
+    }
+
+    // 用法：record convert <日志.jsonl> <记录.bin>   每行一份 Botzone 对局日志
+    //       record replay <记录.bin>                 在每个局面上重新决策，统计和记录里的选择是否一致（不计花色）
+    //       record parse <输入.jsonl> [重复次数]      每行一份 Botzone 输入，核对并比较两条解析路径
+    //       record chunks <文件.jsonl>                 每行一份 JSON，核对切块增量解析和 Json::Reader 一致
+    int run(int argc, char *argv[]) {
+        if (argc >= 3 && !strcmp(argv[1], "chunks")) return chunks(argv[2]);
+        if (argc >= 3 && !strcmp(argv[1], "parse")) return parse(argv[2], argc > 3 ? atoi(argv[3]) : 10);
+        if (argc >= 4 && !strcmp(argv[1], "convert")) {
+            std::ifstream in(argv[2]);
+            FILE *f = fopen(argv[3], "wb");
+            if (!in || !f) {fprintf(stderr, "cannot open files\n"); return 1;}
+            fwrite(MAGIC, 1, sizeof(MAGIC), f);
+            Header h;
+            vector<Mask> plays;
+            unsigned ok = 0, bad = 0;
+            Json::ValueArena arena; // 每局日志解析完整体释放，块留给下一局复用
+            logKeys(); // 先驻留字段名，解析出的成员才能按指针查找
+            for (string line; getline(in, line); arena.release()) {
+                Json::Value root; // 原地解析：字符串直接指向 line，不另复制
+                Json::Reader reader(Json::Features::trusted());
+                if (reader.parseInSitu(&line[0], &line[0] + line.size(), root, arena) && fromLog(root, h, plays)) write(f, h, plays), ++ok;
+                else ++bad;
+            }
+            fclose(f);
+            printf("converted %u games, skipped %u\n", ok, bad);
+            return 0;
+        }
+        if (argc >= 3 && !strcmp(argv[1], "replay")) {
+            Reader r;
+            if (!r.open(argv[2])) {fprintf(stderr, "cannot read %s\n", argv[2]); return 1;}
+            const Header *h;
+            const Mask *plays;
+            GameContext g;
+            BotzoneIO::Request req;
+            string out;
+            unsigned games = 0, total = 0, same = 0;
+            double viewSecs = 0.0;
+            while (r.next(h, plays)) {
+                ++games;
+                unsigned nb = numBids(*h);
+                for (unsigned pos = 0; pos < positions(*h); ++pos) {
+                    auto t = chrono::steady_clock::now();
+                    view(*h, plays, pos, g, req);
+                    viewSecs += chrono::duration<double>(chrono::steady_clock::now() - t).count();
+                    out.clear();
+                    BotzoneIO::captured = &out;
+                    respond(g);
+                    BotzoneIO::captured = nullptr;
+                    Json::Value v;
+                    Json::Reader reader(Json::Features::trusted());
+                    reader.parse(out, v);
+                    const Json::Value &resp = static_cast<const Json::Value &>(v)["response"];
+                    vector<Card> cards;
+                    if (resp.isArray()) BotzoneIO::readCards(resp, cards);
+                    ++total;
+                    same += pos < nb ? resp.isInt() && resp.asInt() == h->bids[pos] : resp.isArray() && sameLevels(toMask(cards), plays[pos - nb]);
+                }
+            }
+            printf("games %u, positions %u, same choice %u (%.3f), rebuild %.2f us/position\n",
+                   games, total, same, total ? double(same) / total : 0.0, total ? viewSecs * 1e6 / total : 0.0);
+            return 0;
+        }
+        fprintf(stderr, "usage: %s convert <log.jsonl> <out.bin> | replay <in.bin> | parse <inputs.jsonl> [repeat] | chunks <file.jsonl>\n", argv[0]);
+        return 1;
+    }
+}
+#endif
+
+// 第一回合的局面已经建好：回应，长时运行时继续处理之后的回合
+// 估值线程池只在这里建，归这一局所有；批量、本地裁判和服务已经在并行处理多个局面，它们的局面不带线程池。
+// 只有一个线程时不建池，估值在调用线程里直接循环
+void serve(GameContext &game) {
+#if EVAL_THREADS != 1
+    ThreadPool pool(EVAL_THREADS ? EVAL_THREADS : std::max(1u, std::thread::hardware_concurrency()));
+    if (pool.size() > 1) game.pool = &pool;
+#endif
+    respond(game);
+    while (KEEP_RUNNING) {
+        BotzoneIO::keepRunning();
+        if (!BotzoneIO::readNext(game)) break;
+        respond(game);
+    }
+    game.pool = nullptr;
+}
+
+void runLocal(const string &first) {
+    GameContext game;
+    BotzoneIO::read(game, first);
+    serve(game);
+}
+
+#ifndef SERVER
+#define SERVER 0 // 1：常驻决策服务，在 SERVER_SOCKET 上监听，预先 fork 出若干工作进程处理请求
+#endif
+#ifndef SERVER_CLIENT
+#define SERVER_CLIENT 0 // 1：客户端外壳，对外和普通 bot 一样读写标准输入输出，决策转给 SERVER_SOCKET 上的服务
+#endif
+#ifndef SERVER_SOCKET
+#define SERVER_SOCKET "/tmp/fightthelandlord.sock"
+#endif
+#ifndef SERVER_WORKERS
+#define SERVER_WORKERS 0 // 工作进程数，0 表示取 CPU 核数
+#endif
+
+#if SERVER || SERVER_CLIENT
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// 协议：一个连接就是一局里的一个座位。客户端每次发一行 Botzone 输入，第一行是完整的 requests/responses，
+// 之后各行和长时运行模式一样只含新的一条请求；服务端对每行回一个和普通 bot 输出逐字节相同的回应（以空行结尾）
+namespace Server {
+    using namespace std;
+
+    sockaddr_un address(const char *path) {
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+        return addr;
+    }
+
+    bool sendAll(int fd, const char *buf, size_t len) {
+        for (ssize_t n; len; buf += n, len -= n)
+            if ((n = write(fd, buf, len)) <= 0) return false;
+        return true;
+    }
+
+    // 从 fd 读到分隔符 delim 为止（不含），多读到的内容留在 pending 里
+    bool recvUntil(int fd, string &pending, const char *delim, string &msg) {
+        for (;;) {
+            size_t at = pending.find(delim);
+            if (at != string::npos) {
+                msg.assign(pending, 0, at), pending.erase(0, at + strlen(delim));
+                return true;
+            }
+            char buf[1 << 16];
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) return false;
+            pending.append(buf, n);
+        }
+    }
+
+#if SERVER
+    // 一个连接对应一份 GameContext，连接关闭时丢弃
+    void serve(int fd) {
+        GameContext g;
+        string pending, line, out;
+        for (bool first = true; recvUntil(fd, pending, "\n", line); first = false) {
+            out.clear();
+            BotzoneIO::captured = &out;
+            if (first) BotzoneIO::read(g, line);
+            else if (!BotzoneIO::readNext(g, line)) break;
+            respond(g);
+            BotzoneIO::captured = nullptr;
+            out += "\n";
+            if (!sendAll(fd, out.data(), out.size())) break;
+        }
+        BotzoneIO::captured = nullptr;
+    }
+
+    // 用法：server [套接字路径] [工作进程数]
+    // 主进程只负责监听并看护工作进程，工作进程各自 accept；退出的工作进程会被重新 fork
+    int run(int argc, char *argv[]) {
+        const char *path = argc > 1 ? argv[1] : SERVER_SOCKET;
+        unsigned workers = argc > 2 ? atoi(argv[2]) : SERVER_WORKERS;
+        if (!workers) workers = max(1u, thread::hardware_concurrency());
+        signal(SIGPIPE, SIG_IGN);
+
+        int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr = address(path);
+        unlink(path);
+        if (lfd < 0 || bind(lfd, (sockaddr *)&addr, sizeof(addr)) || listen(lfd, 128)) {
+            perror("server");
+            return 1;
+        }
+        // 工作进程：描述符或内存暂时不够时歇 100ms 再 accept，不空转；其他错误退出，由主进程稍后重新 fork
+        auto spawn = [&] {
+            pid_t pid = fork();
+            if (pid < 0) perror("server: fork");
+            if (pid) return pid;
+            for (;;) {
+                int fd = accept(lfd, nullptr, nullptr);
+                if (fd < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED) continue;
+                    if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {usleep(100000); continue;}
+                    perror("server: accept");
+                    _exit(1);
+                }
+                serve(fd);
+                close(fd);
+            }
+        };
+        // live 是活着的工作进程数：fork 失败或工作进程出错退出时隔一秒再补，直到补满
+        unsigned live = 0;
+        while (live < workers && spawn() > 0) ++live;
+        fprintf(stderr, "listening on %s with %u of %u workers\n", path, live, workers);
+        for (;;) {
+            while (live < workers && spawn() > 0) ++live;
+            int status;
+            pid_t pid = live < workers ? (sleep(1), waitpid(-1, &status, WNOHANG)) : wait(&status);
+            if (pid > 0) {
+                --live;
+                if (!WIFEXITED(status) || WEXITSTATUS(status)) sleep(1);
+            } else if (pid < 0 && errno != EINTR && errno != ECHILD) {
+                perror("server: wait");
+                return 1;
+            }
+        }
+    }
+#endif
+
+#if SERVER_CLIENT
+    // 外壳：把标准输入的每一行转给服务，把回应原样写到标准输出。一开始就连不上服务时在本进程内决策，
+    // 所以裁判那边看到的行为和普通 bot 一样
+    int client() {
+        string line, pending, resp;
+        BotzoneIO::readLine(line);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr = address(SERVER_SOCKET);
+        if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof(addr))) {
+            if (fd >= 0) close(fd);
+            runLocal(line);
+            return 0;
+        }
+        signal(SIGPIPE, SIG_IGN);
+        for (;;) {
+            line += "\n";
+            if (!sendAll(fd, line.data(), line.size()) || !recvUntil(fd, pending, "\n\n", resp)) return 1;
+            resp += "\n\n";
+            BotzoneIO::writeRaw(resp.data(), resp.size());
+            if (!KEEP_RUNNING) break;
+            BotzoneIO::keepRunning();
+            if (!BotzoneIO::readLine(line)) break;
+        }
+        close(fd);
+        return 0;
+    }
+#endif
+}
+#endif
+
+// 解析器自检，所有构建都带着：bot --self-test 跑一遍，有失败时返回 1（平台调用时不带参数，不受影响）。
+// 覆盖 FastParser 的边界和畸形输入、Json::Reader 的整数边界、IncrementalReader 在任意位置切块（包括转义中间）和截断的文档
+namespace SelfTest {
+    using namespace std;
+
+    unsigned checks, failures;
+
+    void check(bool ok, const string &what, const string &doc) {
+        ++checks;
+        if (!ok) ++failures, fprintf(stderr, "self-test: %s: %s\n", what.c_str(), doc.c_str());
+    }
+
+    // 备用路径：Json::Reader + fromJson，返回是否解析成功
+    bool viaReader(const string &line) {
+        Json::Value input;
+        Json::Reader reader(Json::Features::trusted());
+        BotzoneIO::keys();
+        if (!reader.parse(line, input)) return false;
+        BotzoneIO::fromJson(input);
+        return true;
+    }
+
+    // FastParser 接受的输入，备用路径要得到同样的请求和回应
+    void fastAgrees(const string &line) {
+        using BotzoneIO::requests; using BotzoneIO::responses; using BotzoneIO::numRequests; using BotzoneIO::numResponses;
+        bool fast = BotzoneIO::FastParser(line).input();
+        check(fast, "FastParser rejects", line);
+        if (!fast) return;
+        vector<BotzoneIO::Request> reqs(requests.begin(), requests.begin() + numRequests);
+        vector<vector<Card>> resps(responses.begin(), responses.begin() + numResponses);
+        bool same = viaReader(line) && reqs.size() == numRequests && resps.size() == numResponses;
+        for (unsigned i = 0; same && i < numRequests; ++i) same = reqs[i] == requests[i];
+        for (unsigned i = 0; same && i < numResponses; ++i) same = resps[i] == responses[i];
+        check(same, "FastParser and Json::Reader differ", line);
+    }
+
+    // 先喂 first 字节，之后每块 step 字节（0 表示剩下的一次喂完）；是否成功和得到的树都应和 Json::Reader 一致
+    void incremental(const string &doc, const Json::Features &f, size_t first, size_t step) {
+        Json::Value expected, root;
+        Json::Reader reader(f);
+        bool ok = reader.parse(doc, expected);
+        Json::IncrementalReader inc(f);
+        inc.reset(root);
+        const char *p = doc.data(), *end = p + doc.size();
+        for (size_t size = first; p < end && !inc.done() && !inc.failed(); size = step) {
+            const char *next = size && size_t(end - p) > size ? p + size : end;
+            inc.feed(p, next);
+            p = next;
+        }
+        bool got = inc.finish();
+        check(got == ok && (!ok || root == expected), "IncrementalReader differs at " + to_string(first) + "+" + to_string(step), doc);
+    }
+
+    int run() {
+        const Json::Features features[] = {Json::Features(), Json::Features::trusted()};
+        const string inputs[] = {
+            "{\"requests\":[{\"own\":[0,1,2,53],\"bid\":[]}],\"responses\":[]}",
+            "{\"requests\":[{\"own\":[3,9],\"bid\":[1,2]},{\"history\":[[],[4,5]],\"publiccard\":[6,7,8],\"landlord\":0,\"pos\":2,\"finalbid\":3}],"
+                "\"responses\":[3],\"data\":\"a\\\"b\",\"globaldata\":{\"x\":[1,-2,{\"y\":null}]},\"time_limit\":1.5}",
+            " { \"requests\" : [ { \"own\" : [ 10 ] , \"bid\" : null , \"history\" : null } ] , \"responses\" : [ [ 11 , 12 ] ] }",
+        };
+        for (const string &line : inputs) {
+            fastAgrees(line);
+            // 截断的文档：三条路径都要失败
+            size_t complete = line.rfind('}') + 1;
+            for (size_t n = 0; n < complete; ++n) {
+                string cut = line.substr(0, n);
+                Json::Value v;
+                check(!BotzoneIO::FastParser(cut).input(), "FastParser accepts truncated input", cut);
+                check(!Json::Reader().parse(cut, v), "Json::Reader accepts truncated input", cut);
+                for (const Json::Features &f : features) incremental(cut, f, 0, 0);
+            }
+        }
+
+        // FastParser 只认 0..53 的整数和不带转义的键，其余交给 Json::Reader；畸形的输入两条路径都不接受
+        const string fallback[] = {
+            "{\"requests\":[{\"own\":[54]}],\"responses\":[]}",
+            "{\"requests\":[{\"own\":[-1]}],\"responses\":[]}",
+            "{\"requests\":[{\"own\":[100]}],\"responses\":[]}",
+            "{\"requests\":[{\"own\":[-2147483648]}],\"responses\":[]}",
+            "{\"requests\":[{\"own\":[1.0]}],\"responses\":[]}",
+            "{\"requests\":[{\"own\":[1e1]}],\"responses\":[]}",
+            "{\"re\\u0071uests\":[{\"own\":[5]}],\"responses\":[]}",
+            "{\"requests\":[{\"own\":[5]}],\"responses\":[]} x",
+            "{\"requests\":[{\"history\":[[],[],[]]}],\"responses\":[]}",
+            "{\"requests\":[5,{\"own\":{\"a\":1},\"history\":5}],\"responses\":{}}",
+            "[]",
+            "{\"requests\":[{\"own\":[1,,2]}],\"responses\":[]}",
+            "{\"requests\":[{\"own\":[1 2]}],\"responses\":[]}",
+            "{\"requests\" [],\"responses\":[]}",
+            "",
+        };
+        const unsigned malformed = 11; // 从这里起不是合法的 JSON
+        for (const string &line : fallback)
+            check(!BotzoneIO::FastParser(line).input(), "FastParser accepts", line);
+        for (unsigned i = 0; i < malformed; ++i)
+            check(viaReader(fallback[i]), "Json::Reader rejects", fallback[i]);
+        check(viaReader(fallback[6]) && BotzoneIO::numRequests == 1 && BotzoneIO::requests[0].own == vector<Card>{5},
+              "escaped key not read by Json::Reader", fallback[6]);
+        // 类型不对的结构当作缺失：不抛异常，也不读出牌
+        check(viaReader(fallback[9]) && BotzoneIO::numRequests == 2 && BotzoneIO::numResponses == 0 &&
+              BotzoneIO::requests[1].own.empty() && BotzoneIO::requests[1].hasHistory, "wrong types", fallback[9]);
+        check(viaReader(fallback[10]) && BotzoneIO::numRequests == 0, "top-level array", fallback[10]);
+        for (unsigned i = malformed; i < sizeof(fallback) / sizeof(fallback[0]); ++i)
+            check(!viaReader(fallback[i]), "Json::Reader accepts", fallback[i]);
+
+        // 整数边界：int 放得下的还是 int，放不下的依次是 Int64、UInt64、double
+        const string numbers = "[-2147483648,2147483647,-2147483649,2147483648,"
+            "9223372036854775807,-9223372036854775808,18446744073709551615,18446744073709551616]";
+        for (const Json::Features &f : features) {
+            Json::Value v;
+            bool ok = Json::Reader(f).parse(numbers, v) && v.size() == 8;
+            check(ok && v[0].isInt() && v[0].asInt() == INT_MIN && v[1].isInt() && v[1].asInt() == INT_MAX, "int range", numbers);
+            check(ok && !v[2].isInt() && v[2].asInt64() == Json::Int64(INT_MIN) - 1 &&
+                  !v[3].isInt() && v[3].isUInt() && v[3].asUInt() == 2147483648u, "just outside int", numbers);
+            check(ok && v[4].asInt64() == Json::Value::maxInt64 && v[5].asInt64() == Json::Value::minInt64 &&
+                  v[6].isUInt64() && v[6].asUInt64() == Json::Value::maxUInt64 && v[7].type() == Json::realValue, "64-bit range", numbers);
+        }
+
+        // 切块增量解析：每个切点（包括转义和 \u 序列中间）以及逐字节
+        const string docs[] = {
+            numbers,
+            "{\"k\\u00e9y\":\"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\\u4e2d\\ud83d\\ude00\",\"n\":[-0,1.5e-3,true,false,null],\"e\":{}}",
+            "{\"bad\":\"\\x\"}",
+            "[\"\\ud83d\"]",
+            "[1,]",
+        };
+        for (const string &doc : docs)
+            for (const Json::Features &f : features) {
+                for (size_t first = 1; first < doc.size(); ++first) incremental(doc, f, first, 0);
+                incremental(doc, f, 1, 1);
+            }
+
+        printf("self-test: %u checks, %u failed\n", checks, failures);
+        return failures ? 1 : 0;
+    }
+}
+
+// 带 --self-test 时只跑解析器自检
+int main(int argc, char *argv[]) {
+    if (argc > 1 && !strcmp(argv[1], "--self-test")) return SelfTest::run();
+#if SERVER
+    return Server::run(argc, argv);
+#endif
+#if SERVER_CLIENT
+    return Server::client();
+#endif
+#if ARENA
+    return Arena::run(argc, argv);
+#endif
+#if RECORD_TOOL
+    return Record::run(argc, argv);
+#endif
+    if (BATCH) {
+        runBatch();
+        return 0;
+    }
+#if STREAM_INPUT
+    GameContext game;
+    if (BotzoneIO::read(game)) serve(game);
+#else
+    string line;
+    BotzoneIO::readLine(line);
+    runLocal(line);
+#endif
     return 0;
-}
\ No newline at end of file
+}